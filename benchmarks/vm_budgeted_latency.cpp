@@ -0,0 +1,112 @@
+#include <vivisect/modules/vm_engine.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace vivisect::modules;
+using bench_clock = std::chrono::steady_clock;
+
+struct LatencyReport {
+    size_t jobs = 0;
+    size_t requests = 0;
+    double seconds = 0.0;
+    double p50_us = 0.0;
+    double p99_us = 0.0;
+    double p999_us = 0.0;
+    double max_us = 0.0;
+};
+
+static VMProgram make_loop_program(uint32_t iterations) {
+    const std::array<VMInstruction, 6> code = {{
+        VMInstruction(VMOpcode::LOAD_IMM, 0, 0, 0, iterations),
+        VMInstruction(VMOpcode::LOAD_IMM, 1, 0, 0, 1),
+        VMInstruction(VMOpcode::ADD, 2, 2, 0),
+        VMInstruction(VMOpcode::XOR, 3, 3, 2),
+        VMInstruction(VMOpcode::SUB, 0, 0, 1),
+        VMInstruction(VMOpcode::JUMP_IF_NOT_ZERO, 0, 0, 0, 2),
+    }};
+    auto program = VMProgram::verify(code);
+    if (!program) {
+        std::fprintf(stderr, "verify failed\n");
+        std::exit(1);
+    }
+    return std::move(*program);
+}
+
+static double percentile(std::vector<double>& samples, double fraction) {
+    if (samples.empty()) return 0.0;
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+static LatencyReport run_loop(const VMProgram& program, size_t budget, std::chrono::microseconds interval,
+                              std::chrono::milliseconds duration) {
+    int seed = 0x5eed;
+    VMEngine vm(seed, VMDispatchMode::THREADED);
+    std::vector<double> latencies;
+    LatencyReport report;
+    const auto begin = bench_clock::now();
+    const auto end = begin + duration;
+    auto next_arrival = begin + interval;
+    bool running = false;
+    for (;;) {
+        if (!running) {
+            vm.start(program);
+            running = true;
+        }
+        VMRunStatus status = budget == 0 ? vm.step(static_cast<size_t>(-1)) : vm.step(budget);
+        if (status == VMRunStatus::FAULTED) {
+            std::fprintf(stderr, "program faulted\n");
+            std::exit(1);
+        }
+        if (status == VMRunStatus::COMPLETED) {
+            running = false;
+            ++report.jobs;
+        }
+        const auto now = bench_clock::now();
+        while (next_arrival <= now) {
+            latencies.push_back(std::chrono::duration<double, std::micro>(now - next_arrival).count());
+            next_arrival += interval;
+        }
+        if (now >= end && !running) break;
+    }
+    report.seconds = std::chrono::duration<double>(bench_clock::now() - begin).count();
+    report.requests = latencies.size();
+    report.p50_us = percentile(latencies, 0.50);
+    report.p99_us = percentile(latencies, 0.99);
+    report.p999_us = percentile(latencies, 0.999);
+    report.max_us = latencies.empty() ? 0.0 : *std::max_element(latencies.begin(), latencies.end());
+    return report;
+}
+
+static void print_report(const char* label, const LatencyReport& report) {
+    std::printf("%-22s %10.0f %10zu %10.1f %10.1f %10.1f %10.1f\n", label,
+                static_cast<double>(report.jobs) / report.seconds, report.requests,
+                report.p50_us, report.p99_us, report.p999_us, report.max_us);
+}
+
+int main(int argc, char** argv) {
+    const uint32_t iterations = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 200000;
+    const long interval_us = argc > 2 ? std::strtol(argv[2], nullptr, 10) : 50;
+    const long duration_ms = argc > 3 ? std::strtol(argv[3], nullptr, 10) : 2000;
+    const VMProgram program = make_loop_program(iterations);
+    const std::chrono::microseconds interval(interval_us);
+    const std::chrono::milliseconds duration(duration_ms);
+
+    std::printf("loop iterations %u, request interval %ld us, %ld ms per mode\n",
+                iterations, interval_us, duration_ms);
+    std::printf("%-22s %10s %10s %10s %10s %10s %10s\n",
+                "mode", "jobs/s", "requests", "p50 us", "p99 us", "p99.9 us", "max us");
+    print_report("run to completion", run_loop(program, 0, interval, duration));
+    const size_t budgets[] = {500, 2000, 8000, 32000};
+    for (size_t budget : budgets) {
+        char label[32];
+        std::snprintf(label, sizeof(label), "step(%zu)", budget);
+        print_report(label, run_loop(program, budget, interval, duration));
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <vivisect/modules/vm_engine.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace vivisect::modules;
+using bench_clock = std::chrono::steady_clock;
+
+static constexpr size_t LOOP_BODY = 6;
+
+static std::array<VMInstruction, 8> make_loop(uint32_t iterations) {
+    return {{
+        VMInstruction(VMOpcode::LOAD_IMM, 0, 0, 0, iterations),
+        VMInstruction(VMOpcode::LOAD_IMM, 1, 0, 0, 1),
+        VMInstruction(VMOpcode::ADD, 2, 2, 0),
+        VMInstruction(VMOpcode::XOR, 3, 3, 2),
+        VMInstruction(VMOpcode::STORE, 0, 3, 1, 0),
+        VMInstruction(VMOpcode::LOAD, 4, 1, 0, 0),
+        VMInstruction(VMOpcode::SUB, 0, 0, 1),
+        VMInstruction(VMOpcode::JUMP_IF_NOT_ZERO, 0, 0, 0, 2),
+    }};
+}
+
+template<typename Run>
+static double best_ns_per_instruction(size_t repetitions, double instructions, Run&& run) {
+    double best = 0.0;
+    for (size_t i = 0; i < repetitions; ++i) {
+        const auto begin = bench_clock::now();
+        run();
+        const double ns = std::chrono::duration<double, std::nano>(bench_clock::now() - begin).count();
+        const double per_instruction = ns / instructions;
+        if (i == 0 || per_instruction < best) best = per_instruction;
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    const uint32_t iterations = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 1000000;
+    const size_t repetitions = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 7;
+    const auto code = make_loop(iterations);
+    const auto program = VMProgram::verify(code);
+    if (!program) {
+        std::fprintf(stderr, "verify failed\n");
+        return 1;
+    }
+    const double instructions = 2.0 + static_cast<double>(LOOP_BODY) * iterations;
+
+    int seed = 0x5eed;
+    VMEngine table_vm(seed, VMDispatchMode::HANDLER_TABLE);
+    VMEngine threaded_vm(seed, VMDispatchMode::THREADED);
+    VMEngine verified_vm(seed, VMDispatchMode::THREADED);
+
+    const double table_ns = best_ns_per_instruction(repetitions, instructions, [&] {
+        table_vm.execute(code.data(), code.size());
+    });
+    const double threaded_ns = best_ns_per_instruction(repetitions, instructions, [&] {
+        threaded_vm.execute(code.data(), code.size());
+    });
+    const double verified_ns = best_ns_per_instruction(repetitions, instructions, [&] {
+        verified_vm.execute(*program);
+    });
+    if (table_vm.get_register(3) != threaded_vm.get_register(3) ||
+        table_vm.get_register(3) != verified_vm.get_register(3)) {
+        std::fprintf(stderr, "dispatch modes disagree\n");
+        return 1;
+    }
+
+    std::printf("loop iterations %u, %.0f instructions per run, best of %zu\n",
+                iterations, instructions, repetitions);
+    std::printf("%-26s %12s %10s\n", "path", "ns/instr", "vs table");
+    std::printf("%-26s %12.2f %9.2fx\n", "HANDLER_TABLE", table_ns, 1.0);
+    std::printf("%-26s %12.2f %9.2fx\n", "THREADED", threaded_ns, table_ns / threaded_ns);
+    std::printf("%-26s %12.2f %9.2fx\n", "THREADED, verified program", verified_ns, table_ns / verified_ns);
+    return 0;
+}
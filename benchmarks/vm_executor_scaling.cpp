@@ -0,0 +1,68 @@
+#include <vivisect/modules/vm_executor.hpp>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace vivisect::modules;
+using bench_clock = std::chrono::steady_clock;
+
+static VMExecutor::ProgramPtr make_loop_program() {
+    const std::array<VMInstruction, 5> code = {{
+        VMInstruction(VMOpcode::LOAD_IMM, 1, 0, 0, 1),
+        VMInstruction(VMOpcode::ADD, 2, 2, 0),
+        VMInstruction(VMOpcode::XOR, 3, 3, 2),
+        VMInstruction(VMOpcode::SUB, 0, 0, 1),
+        VMInstruction(VMOpcode::JUMP_IF_NOT_ZERO, 0, 0, 0, 1),
+    }};
+    auto program = VMProgram::verify(code);
+    if (!program) {
+        std::fprintf(stderr, "verify failed\n");
+        std::exit(1);
+    }
+    return std::make_shared<const VMProgram>(std::move(*program));
+}
+
+static double run_jobs(size_t workers, const VMExecutor::ProgramPtr& program, uint32_t iterations, size_t jobs) {
+    VMExecutor executor(workers, 0x5eed);
+    std::vector<std::future<VMJobResult>> results;
+    results.reserve(jobs);
+    const auto begin = bench_clock::now();
+    for (size_t i = 0; i < jobs; ++i) {
+        results.push_back(executor.submit(program, {iterations}));
+    }
+    for (auto& result : results) {
+        if (result.get().status != VMRunStatus::COMPLETED) {
+            std::fprintf(stderr, "job failed\n");
+            std::exit(1);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(bench_clock::now() - begin).count();
+    return static_cast<double>(jobs) / seconds;
+}
+
+int main(int argc, char** argv) {
+    size_t max_workers = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    const size_t jobs = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20000;
+    if (max_workers == 0) max_workers = 1;
+    const VMExecutor::ProgramPtr program = make_loop_program();
+    const uint32_t sizes[] = {16, 1000, 50000};
+
+    std::printf("hardware threads %u, %zu jobs per run\n", std::thread::hardware_concurrency(), jobs);
+    for (uint32_t iterations : sizes) {
+        const size_t job_count = iterations >= 50000 ? jobs / 20 + 1 : jobs;
+        std::printf("\nloop iterations %u (%zu jobs)\n", iterations, job_count);
+        std::printf("%8s %12s %10s %11s\n", "workers", "jobs/s", "speedup", "efficiency");
+        double baseline = 0.0;
+        for (size_t workers = 1; workers <= max_workers; ++workers) {
+            const double rate = run_jobs(workers, program, iterations, job_count);
+            if (workers == 1) baseline = rate;
+            const double speedup = rate / baseline;
+            std::printf("%8zu %12.0f %9.2fx %10.0f%%\n", workers, rate, speedup,
+                        100.0 * speedup / static_cast<double>(workers));
+        }
+    }
+    return 0;
+}
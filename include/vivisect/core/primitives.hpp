@@ -1,6 +1,7 @@
 #ifndef VIVISECT_CORE_PRIMITIVES_HPP
 #define VIVISECT_CORE_PRIMITIVES_HPP
 #include <cstdint>
+#include <cstddef>
 #include <type_traits>
 #include <concepts>
 namespace vivisect::core {
@@ -24,6 +25,10 @@ inline void volatile_seed_update(int& seed) {
     volatile int temp = seed;
     seed = temp ^ 0xDEADBEEF;
 }
+inline void secure_wipe(void* data, size_t length) {
+    volatile uint8_t* bytes = static_cast<volatile uint8_t*>(data);
+    for (size_t i = 0; i < length; ++i) bytes[i] = 0;
+}
 template<typename T>
 requires (std::is_integral_v<T> || std::is_pointer_v<T>)
 constexpr bool opaque_true(T value, int seed) {
@@ -0,0 +1,262 @@
+#ifndef VIVISECT_CORE_SIMD_HPP
+#define VIVISECT_CORE_SIMD_HPP
+#include <cstdint>
+#include <cstddef>
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define VIVISECT_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define VIVISECT_SIMD_SSE2
+#endif
+#if !defined(VIVISECT_SIMD_AVX2) && !defined(VIVISECT_NO_RUNTIME_DISPATCH) && (defined(__x86_64__) || defined(_M_X64))
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #include <immintrin.h>
+        #define VIVISECT_SIMD_AVX2_DISPATCH
+        #define VIVISECT_SIMD_AVX2_TARGET
+    #elif defined(__GNUC__) || defined(__clang__)
+        #include <immintrin.h>
+        #define VIVISECT_SIMD_AVX2_DISPATCH
+        #define VIVISECT_SIMD_AVX2_TARGET __attribute__((target("avx2")))
+    #endif
+#endif
+namespace vivisect::core::simd {
+#if defined(VIVISECT_SIMD_AVX2)
+struct U32Vec {
+    static constexpr size_t WIDTH = 8;
+    __m256i v;
+    static U32Vec load(const uint32_t* p) {
+        return {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))};
+    }
+    static U32Vec broadcast(uint32_t x) {
+        return {_mm256_set1_epi32(static_cast<int>(x))};
+    }
+    static U32Vec from_bits(uint32_t bits) {
+        const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        return {_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(bits)), lane_bits), lane_bits)};
+    }
+    void store(uint32_t* p) const {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+    }
+    uint32_t to_bits() const {
+        return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(v)));
+    }
+};
+inline U32Vec add(U32Vec a, U32Vec b) { return {_mm256_add_epi32(a.v, b.v)}; }
+inline U32Vec sub(U32Vec a, U32Vec b) { return {_mm256_sub_epi32(a.v, b.v)}; }
+inline U32Vec mul(U32Vec a, U32Vec b) { return {_mm256_mullo_epi32(a.v, b.v)}; }
+inline U32Vec bit_xor(U32Vec a, U32Vec b) { return {_mm256_xor_si256(a.v, b.v)}; }
+inline U32Vec bit_and(U32Vec a, U32Vec b) { return {_mm256_and_si256(a.v, b.v)}; }
+inline U32Vec bit_or(U32Vec a, U32Vec b) { return {_mm256_or_si256(a.v, b.v)}; }
+inline U32Vec bit_not(U32Vec a) { return {_mm256_xor_si256(a.v, _mm256_set1_epi32(-1))}; }
+inline U32Vec shl(U32Vec a, U32Vec b) {
+    return {_mm256_sllv_epi32(a.v, _mm256_and_si256(b.v, _mm256_set1_epi32(31)))};
+}
+inline U32Vec shr(U32Vec a, U32Vec b) {
+    return {_mm256_srlv_epi32(a.v, _mm256_and_si256(b.v, _mm256_set1_epi32(31)))};
+}
+inline U32Vec is_zero(U32Vec a) { return {_mm256_cmpeq_epi32(a.v, _mm256_setzero_si256())}; }
+inline U32Vec select(U32Vec mask, U32Vec a, U32Vec b) { return {_mm256_blendv_epi8(b.v, a.v, mask.v)}; }
+template<int N>
+inline U32Vec shl_by(U32Vec a) { return {_mm256_slli_epi32(a.v, N)}; }
+template<int N>
+inline U32Vec shr_by(U32Vec a) { return {_mm256_srli_epi32(a.v, N)}; }
+inline void deinterleave(const uint32_t* p, U32Vec& even, U32Vec& odd) {
+    const __m256 a = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    const __m256 b = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8)));
+    even = {_mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)))};
+    odd = {_mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)))};
+}
+inline void interleave(U32Vec even, U32Vec odd, uint32_t* p) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm256_unpacklo_epi32(even.v, odd.v));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + 8), _mm256_unpackhi_epi32(even.v, odd.v));
+}
+#elif defined(VIVISECT_SIMD_SSE2)
+struct U32Vec {
+    static constexpr size_t WIDTH = 4;
+    __m128i v;
+    static U32Vec load(const uint32_t* p) {
+        return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))};
+    }
+    static U32Vec broadcast(uint32_t x) {
+        return {_mm_set1_epi32(static_cast<int>(x))};
+    }
+    static U32Vec from_bits(uint32_t bits) {
+        const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+        return {_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(static_cast<int>(bits)), lane_bits), lane_bits)};
+    }
+    void store(uint32_t* p) const {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+    }
+    uint32_t to_bits() const {
+        return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(v)));
+    }
+};
+inline U32Vec add(U32Vec a, U32Vec b) { return {_mm_add_epi32(a.v, b.v)}; }
+inline U32Vec sub(U32Vec a, U32Vec b) { return {_mm_sub_epi32(a.v, b.v)}; }
+inline U32Vec mul(U32Vec a, U32Vec b) {
+    __m128i even = _mm_mul_epu32(a.v, b.v);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a.v, 32), _mm_srli_epi64(b.v, 32));
+    return {_mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                               _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)))};
+}
+inline U32Vec bit_xor(U32Vec a, U32Vec b) { return {_mm_xor_si128(a.v, b.v)}; }
+inline U32Vec bit_and(U32Vec a, U32Vec b) { return {_mm_and_si128(a.v, b.v)}; }
+inline U32Vec bit_or(U32Vec a, U32Vec b) { return {_mm_or_si128(a.v, b.v)}; }
+inline U32Vec bit_not(U32Vec a) { return {_mm_xor_si128(a.v, _mm_set1_epi32(-1))}; }
+inline U32Vec shl(U32Vec a, U32Vec b) {
+    alignas(16) uint32_t x[4], n[4];
+    a.store(x);
+    b.store(n);
+    for (size_t i = 0; i < 4; ++i) x[i] <<= (n[i] & 31);
+    return U32Vec::load(x);
+}
+inline U32Vec shr(U32Vec a, U32Vec b) {
+    alignas(16) uint32_t x[4], n[4];
+    a.store(x);
+    b.store(n);
+    for (size_t i = 0; i < 4; ++i) x[i] >>= (n[i] & 31);
+    return U32Vec::load(x);
+}
+inline U32Vec is_zero(U32Vec a) { return {_mm_cmpeq_epi32(a.v, _mm_setzero_si128())}; }
+inline U32Vec select(U32Vec mask, U32Vec a, U32Vec b) {
+    return {_mm_or_si128(_mm_and_si128(mask.v, a.v), _mm_andnot_si128(mask.v, b.v))};
+}
+template<int N>
+inline U32Vec shl_by(U32Vec a) { return {_mm_slli_epi32(a.v, N)}; }
+template<int N>
+inline U32Vec shr_by(U32Vec a) { return {_mm_srli_epi32(a.v, N)}; }
+inline void deinterleave(const uint32_t* p, U32Vec& even, U32Vec& odd) {
+    const __m128 a = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    const __m128 b = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4)));
+    even = {_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)))};
+    odd = {_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)))};
+}
+inline void interleave(U32Vec even, U32Vec odd, uint32_t* p) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_unpacklo_epi32(even.v, odd.v));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 4), _mm_unpackhi_epi32(even.v, odd.v));
+}
+#else
+struct U32Vec {
+    static constexpr size_t WIDTH = 4;
+    uint32_t v[4];
+    static U32Vec load(const uint32_t* p) {
+        return {{p[0], p[1], p[2], p[3]}};
+    }
+    static U32Vec broadcast(uint32_t x) {
+        return {{x, x, x, x}};
+    }
+    static U32Vec from_bits(uint32_t bits) {
+        U32Vec r;
+        for (size_t i = 0; i < 4; ++i) r.v[i] = ((bits >> i) & 1) ? 0xFFFFFFFFu : 0;
+        return r;
+    }
+    void store(uint32_t* p) const {
+        for (size_t i = 0; i < 4; ++i) p[i] = v[i];
+    }
+    uint32_t to_bits() const {
+        uint32_t bits = 0;
+        for (size_t i = 0; i < 4; ++i) bits |= (v[i] >> 31) << i;
+        return bits;
+    }
+};
+template<typename Fn>
+inline U32Vec lanewise(U32Vec a, U32Vec b, Fn fn) {
+    U32Vec r;
+    for (size_t i = 0; i < 4; ++i) r.v[i] = fn(a.v[i], b.v[i]);
+    return r;
+}
+inline U32Vec add(U32Vec a, U32Vec b) { return lanewise(a, b, [](uint32_t x, uint32_t y) { return x + y; }); }
+inline U32Vec sub(U32Vec a, U32Vec b) { return lanewise(a, b, [](uint32_t x, uint32_t y) { return x - y; }); }
+inline U32Vec mul(U32Vec a, U32Vec b) { return lanewise(a, b, [](uint32_t x, uint32_t y) { return x * y; }); }
+inline U32Vec bit_xor(U32Vec a, U32Vec b) { return lanewise(a, b, [](uint32_t x, uint32_t y) { return x ^ y; }); }
+inline U32Vec bit_and(U32Vec a, U32Vec b) { return lanewise(a, b, [](uint32_t x, uint32_t y) { return x & y; }); }
+inline U32Vec bit_or(U32Vec a, U32Vec b) { return lanewise(a, b, [](uint32_t x, uint32_t y) { return x | y; }); }
+inline U32Vec bit_not(U32Vec a) { return lanewise(a, a, [](uint32_t x, uint32_t) { return ~x; }); }
+inline U32Vec shl(U32Vec a, U32Vec b) { return lanewise(a, b, [](uint32_t x, uint32_t y) { return x << (y & 31); }); }
+inline U32Vec shr(U32Vec a, U32Vec b) { return lanewise(a, b, [](uint32_t x, uint32_t y) { return x >> (y & 31); }); }
+inline U32Vec is_zero(U32Vec a) {
+    return lanewise(a, a, [](uint32_t x, uint32_t) { return x == 0 ? 0xFFFFFFFFu : 0u; });
+}
+inline U32Vec select(U32Vec mask, U32Vec a, U32Vec b) {
+    U32Vec r;
+    for (size_t i = 0; i < 4; ++i) r.v[i] = (mask.v[i] & a.v[i]) | (~mask.v[i] & b.v[i]);
+    return r;
+}
+template<int N>
+inline U32Vec shl_by(U32Vec a) { return lanewise(a, a, [](uint32_t x, uint32_t) { return x << N; }); }
+template<int N>
+inline U32Vec shr_by(U32Vec a) { return lanewise(a, a, [](uint32_t x, uint32_t) { return x >> N; }); }
+inline void deinterleave(const uint32_t* p, U32Vec& even, U32Vec& odd) {
+    for (size_t i = 0; i < 4; ++i) {
+        even.v[i] = p[i * 2];
+        odd.v[i] = p[i * 2 + 1];
+    }
+}
+inline void interleave(U32Vec even, U32Vec odd, uint32_t* p) {
+    for (size_t i = 0; i < 4; ++i) {
+        p[i * 2] = even.v[i];
+        p[i * 2 + 1] = odd.v[i];
+    }
+}
+#endif
+#if defined(VIVISECT_SIMD_AVX2) || defined(VIVISECT_SIMD_SSE2)
+inline constexpr bool NATIVE_VECTORS = true;
+#else
+inline constexpr bool NATIVE_VECTORS = false;
+#endif
+template<int N>
+inline U32Vec rotl_by(U32Vec a) { return bit_or(shl_by<N>(a), shr_by<32 - N>(a)); }
+#if defined(VIVISECT_SIMD_AVX2_DISPATCH)
+inline bool detect_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    if (!os_saves_ymm) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+inline bool has_avx2() {
+    static const bool supported = detect_avx2();
+    return supported;
+}
+namespace avx2 {
+struct U32Vec {
+    static constexpr size_t WIDTH = 8;
+    __m256i v;
+    VIVISECT_SIMD_AVX2_TARGET static U32Vec broadcast(uint32_t x) {
+        return {_mm256_set1_epi32(static_cast<int>(x))};
+    }
+};
+VIVISECT_SIMD_AVX2_TARGET inline U32Vec add(U32Vec a, U32Vec b) { return {_mm256_add_epi32(a.v, b.v)}; }
+VIVISECT_SIMD_AVX2_TARGET inline U32Vec sub(U32Vec a, U32Vec b) { return {_mm256_sub_epi32(a.v, b.v)}; }
+VIVISECT_SIMD_AVX2_TARGET inline U32Vec bit_xor(U32Vec a, U32Vec b) { return {_mm256_xor_si256(a.v, b.v)}; }
+VIVISECT_SIMD_AVX2_TARGET inline U32Vec bit_or(U32Vec a, U32Vec b) { return {_mm256_or_si256(a.v, b.v)}; }
+template<int N>
+VIVISECT_SIMD_AVX2_TARGET inline U32Vec shl_by(U32Vec a) { return {_mm256_slli_epi32(a.v, N)}; }
+template<int N>
+VIVISECT_SIMD_AVX2_TARGET inline U32Vec shr_by(U32Vec a) { return {_mm256_srli_epi32(a.v, N)}; }
+template<int N>
+VIVISECT_SIMD_AVX2_TARGET inline U32Vec rotl_by(U32Vec a) { return bit_or(shl_by<N>(a), shr_by<32 - N>(a)); }
+VIVISECT_SIMD_AVX2_TARGET inline void deinterleave(const uint32_t* p, U32Vec& even, U32Vec& odd) {
+    const __m256 a = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    const __m256 b = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8)));
+    even = {_mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)))};
+    odd = {_mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)))};
+}
+VIVISECT_SIMD_AVX2_TARGET inline void interleave(U32Vec even, U32Vec odd, uint32_t* p) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm256_unpacklo_epi32(even.v, odd.v));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + 8), _mm256_unpackhi_epi32(even.v, odd.v));
+}
+}
+#endif
+}
+#endif
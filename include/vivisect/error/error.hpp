@@ -21,6 +21,7 @@ enum class ErrorCode : uint32_t {
     VM_STACK_OVERFLOW = 2005,
     VM_STACK_UNDERFLOW = 2006,
     STRING_DECRYPT_FAILED = 2007,
+    VM_INVALID_JUMP_TARGET = 2008,
     INVALID_PARAMETER = 3000,
     INCOMPATIBLE_MODULES = 3001,
     FEATURE_UNAVAILABLE = 3002,
@@ -1,6 +1,8 @@
 #ifndef VIVISECT_INTEGRATION_MAIN_PROTECT_HPP
 #define VIVISECT_INTEGRATION_MAIN_PROTECT_HPP
 #include "../modules/vm_engine.hpp"
+#include "../modules/vm_assembler.hpp"
+#include "../modules/vm_compiled.hpp"
 #include "../modules/anti_debug.hpp"
 #include "../modules/control_flow.hpp"
 #include "../modules/junk_code.hpp"
@@ -14,6 +16,7 @@ struct MainProtectionConfig {
     bool enable_control_flow = true;
     bool enable_junk_code = true;
     bool enable_exception_handling = true;
+    bool compile_vm_prologue = false;
     modules::DebuggerResponse debugger_response = modules::DebuggerResponse::EXIT_PROCESS;
     int junk_code_density = 3;
     std::function<void()> custom_prologue = nullptr;
@@ -28,6 +31,27 @@ struct MainProtectionConfig {
     }
 };
 inline MainProtectionConfig main_protection_config;
+inline constexpr auto prologue_program = modules::VMAssembler::assemble([] {
+    using namespace modules::vm_asm;
+    return std::array{
+        load_imm(0, 0xDEADBEEF),
+        load_imm(1, 0xCAFEBABE),
+        xor_op(2, 0, 1),
+        mangle_key(3, 2),
+        junk_op(),
+        nop()
+    };
+});
+inline constexpr auto epilogue_program = modules::VMAssembler::assemble([] {
+    using namespace modules::vm_asm;
+    return std::array{
+        load_imm(0, 0x12345678),
+        not_op(1, 0),
+        xor_op(2, 0, 1),
+        junk_op(),
+        mangle_key(3, 2)
+    };
+});
 inline void execute_prologue() {
     if (main_protection_config.custom_prologue) {
         main_protection_config.custom_prologue();
@@ -36,16 +60,13 @@ inline void execute_prologue() {
         modules::JunkCodeGenerator::insert_with_density(main_protection_config.junk_code_density);
     }
     if (main_protection_config.enable_vm_prologue) {
-        modules::VMEngine vm(vivisect::core::global_seed);
-        modules::VMInstruction init_bytecode[] = {
-            modules::VMInstruction(modules::VMOpcode::LOAD_IMM, 0, 0, 0, 0xDEADBEEF),
-            modules::VMInstruction(modules::VMOpcode::LOAD_IMM, 1, 0, 0, 0xCAFEBABE),
-            modules::VMInstruction(modules::VMOpcode::XOR, 2, 0, 1, 0),
-            modules::VMInstruction(modules::VMOpcode::MANGLE_KEY, 3, 2, 0, 0),
-            modules::VMInstruction(modules::VMOpcode::JUNK_OP, 0, 0, 0, 0),
-            modules::VMInstruction(modules::VMOpcode::NOP, 0, 0, 0, 0)
-        };
-        vm.execute(init_bytecode, 6);
+        static thread_local modules::VMEngine vm(vivisect::core::global_seed);
+        vm.reset();
+        if (main_protection_config.compile_vm_prologue) {
+            modules::VMCompiledProgram<prologue_program>::execute(vm);
+        } else {
+            vm.execute(prologue_program);
+        }
     }
     if (main_protection_config.enable_anti_debug) {
         VIVISECT_ANTI_DEBUG(main_protection_config.debugger_response);
@@ -59,15 +80,13 @@ inline void execute_epilogue() {
         modules::JunkCodeGenerator::insert_with_opaque_predicate();
     }
     if (main_protection_config.enable_vm_prologue) {
-        modules::VMEngine vm(vivisect::core::global_seed);
-        modules::VMInstruction cleanup_bytecode[] = {
-            modules::VMInstruction(modules::VMOpcode::LOAD_IMM, 0, 0, 0, 0x12345678),
-            modules::VMInstruction(modules::VMOpcode::NOT, 1, 0, 0, 0),
-            modules::VMInstruction(modules::VMOpcode::XOR, 2, 0, 1, 0),
-            modules::VMInstruction(modules::VMOpcode::JUNK_OP, 0, 0, 0, 0),
-            modules::VMInstruction(modules::VMOpcode::MANGLE_KEY, 3, 2, 0, 0)
-        };
-        vm.execute(cleanup_bytecode, 5);
+        static thread_local modules::VMEngine vm(vivisect::core::global_seed);
+        vm.reset();
+        if (main_protection_config.compile_vm_prologue) {
+            modules::VMCompiledProgram<epilogue_program>::execute(vm);
+        } else {
+            vm.execute(epilogue_program);
+        }
     }
     if (main_protection_config.custom_epilogue) {
         main_protection_config.custom_epilogue();
@@ -0,0 +1,164 @@
+#ifndef VIVISECT_MODULES_BLOB_CRYPT_HPP
+#define VIVISECT_MODULES_BLOB_CRYPT_HPP
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "string_crypt.hpp"
+#include "../core/primitives.hpp"
+#include "../error/error.hpp"
+namespace vivisect::modules {
+struct EncryptedBlobInfo {
+    uint64_t size;
+    uint32_t nonce;
+    std::array<uint32_t, 4> key;
+};
+template<typename Cipher = XTEACipher>
+class EncryptedBlob {
+public:
+    static constexpr size_t CHUNK_BYTES = 4096;
+    class Reader;
+    constexpr EncryptedBlob(const uint8_t* data, const EncryptedBlobInfo& info)
+        : data_(data), size_(static_cast<size_t>(info.size)), cipher_(info.key, info.nonce) {}
+    size_t size() const { return size_; }
+    size_t read(size_t offset, uint8_t* out, size_t length) const {
+        if (offset >= size_) return 0;
+        if (length > size_ - offset) length = size_ - offset;
+        std::memcpy(out, data_ + offset, length);
+        cipher_.apply(out, offset, length);
+        return length;
+    }
+    Reader reader(size_t offset = 0) const {
+        return Reader(*this, offset);
+    }
+    template<typename Callback>
+    void for_each_chunk(Callback&& callback, size_t offset = 0, size_t length = SIZE_MAX) const {
+        uint8_t chunk[CHUNK_BYTES];
+        if (offset > size_) offset = size_;
+        const size_t end = (length > size_ - offset) ? size_ : offset + length;
+        while (offset < end) {
+            const size_t count = read(offset, chunk, (end - offset < CHUNK_BYTES) ? end - offset : CHUNK_BYTES);
+            callback(std::span<const uint8_t>(chunk, count));
+            offset += count;
+        }
+        core::secure_wipe(chunk, sizeof(chunk));
+    }
+    template<typename OutputIt>
+    OutputIt copy(OutputIt out, size_t offset = 0, size_t length = SIZE_MAX) const {
+        for_each_chunk([&](std::span<const uint8_t> chunk) {
+            out = std::copy(chunk.begin(), chunk.end(), out);
+        }, offset, length);
+        return out;
+    }
+private:
+    const uint8_t* data_;
+    size_t size_;
+    CounterModeCipher<Cipher> cipher_;
+};
+template<typename Cipher>
+class EncryptedBlob<Cipher>::Reader {
+public:
+    size_t read(uint8_t* out, size_t capacity) {
+        const size_t count = blob_.read(position_, out, capacity);
+        position_ += count;
+        return count;
+    }
+    void seek(size_t position) {
+        position_ = position < blob_.size() ? position : blob_.size();
+    }
+    size_t position() const { return position_; }
+    size_t remaining() const { return blob_.size() - position_; }
+    bool done() const { return position_ == blob_.size(); }
+private:
+    friend class EncryptedBlob;
+    Reader(const EncryptedBlob& blob, size_t position) : blob_(blob), position_(0) { seek(position); }
+    EncryptedBlob blob_;
+    size_t position_;
+};
+template<typename Cipher = XTEACipher>
+class EncryptedBlobWriter {
+public:
+    using Key = std::array<uint32_t, 4>;
+    EncryptedBlobWriter(const Key& key, uint32_t nonce) : key_(key), nonce_(nonce) {}
+    EncryptedBlobWriter() {
+        std::random_device device;
+        for (uint32_t& word : key_) word = device();
+        nonce_ = device();
+    }
+    std::vector<uint8_t> encrypt(const uint8_t* data, size_t size) const {
+        std::vector<uint8_t> result(data, data + size);
+        CounterModeCipher<Cipher>(key_, nonce_).apply(result.data(), 0, result.size());
+        return result;
+    }
+    std::string header(std::string_view name, const uint8_t* data, size_t size) const {
+        if (!valid_name(name)) {
+            VIVISECT_ERROR(error::ErrorCode::INVALID_PARAMETER, "Blob: Name must be a C++ identifier");
+            return std::string();
+        }
+        static constexpr char HEX[] = "0123456789abcdef";
+        const std::vector<uint8_t> encrypted = encrypt(data, size);
+        const std::string symbol = "vivisect_blob_" + std::string(name);
+        std::string out;
+        out.reserve(encrypted.size() * 5 + encrypted.size() / 16 * 2 + 512);
+        out += "#pragma once\n#include <vivisect/modules/blob_crypt.hpp>\n";
+        out += "using " + symbol + "_cipher = vivisect::modules::" + Cipher::NAME + ";\n";
+        out += "alignas(8) inline constexpr unsigned char " + symbol + "[] = {";
+        for (size_t i = 0; i < encrypted.size(); ++i) {
+            out += (i % 16 == 0) ? "\n    " : " ";
+            out += "0x";
+            out += HEX[encrypted[i] >> 4];
+            out += HEX[encrypted[i] & 15];
+            out += ',';
+        }
+        if (encrypted.empty()) out += "0";
+        out += "\n};\n";
+        out += "inline constexpr vivisect::modules::EncryptedBlobInfo " + symbol + "_info{" +
+               std::to_string(size) + "u, " + std::to_string(nonce_) + "u, {" +
+               std::to_string(key_[0]) + "u, " + std::to_string(key_[1]) + "u, " +
+               std::to_string(key_[2]) + "u, " + std::to_string(key_[3]) + "u}};\n";
+        return out;
+    }
+    bool write_header(const char* input_path, const char* output_path, std::string_view name) const {
+        std::ifstream input(input_path, std::ios::binary);
+        if (!input) {
+            VIVISECT_ERROR(error::ErrorCode::MODULE_LOAD_FAILED, "Blob: Cannot open input file");
+            return false;
+        }
+        const std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        const std::string text = header(name, data.data(), data.size());
+        if (text.empty()) return false;
+        std::ofstream output(output_path, std::ios::binary | std::ios::trunc);
+        output.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (!output) {
+            VIVISECT_ERROR(error::ErrorCode::MODULE_LOAD_FAILED, "Blob: Cannot write header file");
+            return false;
+        }
+        return true;
+    }
+    const Key& key() const { return key_; }
+    uint32_t nonce() const { return nonce_; }
+private:
+    Key key_{};
+    uint32_t nonce_ = 0;
+    static bool valid_name(std::string_view name) {
+        if (name.empty()) return false;
+        for (size_t i = 0; i < name.size(); ++i) {
+            const char c = name[i];
+            const bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+            if (!alpha && !(i > 0 && c >= '0' && c <= '9')) return false;
+        }
+        return true;
+    }
+};
+#define VIVISECT_BLOB(name) \
+    vivisect::modules::EncryptedBlob<vivisect_blob_##name##_cipher>( \
+        vivisect_blob_##name, vivisect_blob_##name##_info)
+}
+#endif
@@ -2,15 +2,26 @@
 #define VIVISECT_MODULES_STRING_CRYPT_HPP
 #include <cstdint>
 #include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <cstring>
 #include "../core/primitives.hpp"
 #include "../core/random.hpp"
 #include "../core/concepts.hpp"
+#include "../core/simd.hpp"
 #include "../error/error.hpp"
 namespace vivisect::modules {
 class XTEACipher {
 public:
+    static constexpr const char* NAME = "XTEACipher";
     static constexpr uint32_t DELTA = 0x9E3779B9;
     static constexpr uint32_t ROUNDS = 32;
     static constexpr void encrypt(uint32_t& v0, uint32_t& v1, const uint32_t* key) {
@@ -29,19 +40,112 @@ public:
             v0 -= (((v1 << 4) ^ (v1 >> 5)) + v1) ^ (sum + key[sum & 3]);
         }
     }
+    static constexpr size_t BATCH_BLOCKS = core::simd::U32Vec::WIDTH;
     static constexpr void encrypt_buffer(uint32_t* data, size_t num_blocks, const uint32_t* key) {
-        for (size_t i = 0; i < num_blocks; ++i) {
+        size_t i = 0;
+        if (!std::is_constant_evaluated()) {
+            i = encrypt_vectors(data, num_blocks, key);
+        }
+        for (; i < num_blocks; ++i) {
             encrypt(data[i * 2], data[i * 2 + 1], key);
         }
     }
     static constexpr void decrypt_buffer(uint32_t* data, size_t num_blocks, const uint32_t* key) {
-        for (size_t i = 0; i < num_blocks; ++i) {
+        size_t i = 0;
+        if (!std::is_constant_evaluated()) {
+            i = decrypt_vectors(data, num_blocks, key);
+        }
+        for (; i < num_blocks; ++i) {
             decrypt(data[i * 2], data[i * 2 + 1], key);
         }
     }
+private:
+    static size_t encrypt_vectors(uint32_t* data, size_t num_blocks, const uint32_t* key) {
+        size_t i = 0;
+#if defined(VIVISECT_SIMD_AVX2_DISPATCH)
+        if (core::simd::has_avx2()) i = encrypt_avx2(data, num_blocks, key);
+#endif
+        if (core::simd::NATIVE_VECTORS) {
+            for (; i + BATCH_BLOCKS <= num_blocks; i += BATCH_BLOCKS) {
+                encrypt_batch(data + i * 2, key);
+            }
+        }
+        return i;
+    }
+    static size_t decrypt_vectors(uint32_t* data, size_t num_blocks, const uint32_t* key) {
+        size_t i = 0;
+#if defined(VIVISECT_SIMD_AVX2_DISPATCH)
+        if (core::simd::has_avx2()) i = decrypt_avx2(data, num_blocks, key);
+#endif
+        if (core::simd::NATIVE_VECTORS) {
+            for (; i + BATCH_BLOCKS <= num_blocks; i += BATCH_BLOCKS) {
+                decrypt_batch(data + i * 2, key);
+            }
+        }
+        return i;
+    }
+    static void encrypt_batch(uint32_t* data, const uint32_t* key) {
+        using namespace core::simd;
+        U32Vec v0, v1;
+        deinterleave(data, v0, v1);
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < ROUNDS; ++i) {
+            v0 = add(v0, bit_xor(add(bit_xor(shl_by<4>(v1), shr_by<5>(v1)), v1), U32Vec::broadcast(sum + key[sum & 3])));
+            sum += DELTA;
+            v1 = add(v1, bit_xor(add(bit_xor(shl_by<4>(v0), shr_by<5>(v0)), v0), U32Vec::broadcast(sum + key[(sum >> 11) & 3])));
+        }
+        interleave(v0, v1, data);
+    }
+    static void decrypt_batch(uint32_t* data, const uint32_t* key) {
+        using namespace core::simd;
+        U32Vec v0, v1;
+        deinterleave(data, v0, v1);
+        uint32_t sum = DELTA * ROUNDS;
+        for (uint32_t i = 0; i < ROUNDS; ++i) {
+            v1 = sub(v1, bit_xor(add(bit_xor(shl_by<4>(v0), shr_by<5>(v0)), v0), U32Vec::broadcast(sum + key[(sum >> 11) & 3])));
+            sum -= DELTA;
+            v0 = sub(v0, bit_xor(add(bit_xor(shl_by<4>(v1), shr_by<5>(v1)), v1), U32Vec::broadcast(sum + key[sum & 3])));
+        }
+        interleave(v0, v1, data);
+    }
+#if defined(VIVISECT_SIMD_AVX2_DISPATCH)
+    VIVISECT_SIMD_AVX2_TARGET static size_t encrypt_avx2(uint32_t* data, size_t num_blocks, const uint32_t* key) {
+        using namespace core::simd::avx2;
+        size_t i = 0;
+        for (; i + U32Vec::WIDTH <= num_blocks; i += U32Vec::WIDTH) {
+            U32Vec v0, v1;
+            deinterleave(data + i * 2, v0, v1);
+            uint32_t sum = 0;
+            for (uint32_t round = 0; round < ROUNDS; ++round) {
+                v0 = add(v0, bit_xor(add(bit_xor(shl_by<4>(v1), shr_by<5>(v1)), v1), U32Vec::broadcast(sum + key[sum & 3])));
+                sum += DELTA;
+                v1 = add(v1, bit_xor(add(bit_xor(shl_by<4>(v0), shr_by<5>(v0)), v0), U32Vec::broadcast(sum + key[(sum >> 11) & 3])));
+            }
+            interleave(v0, v1, data + i * 2);
+        }
+        return i;
+    }
+    VIVISECT_SIMD_AVX2_TARGET static size_t decrypt_avx2(uint32_t* data, size_t num_blocks, const uint32_t* key) {
+        using namespace core::simd::avx2;
+        size_t i = 0;
+        for (; i + U32Vec::WIDTH <= num_blocks; i += U32Vec::WIDTH) {
+            U32Vec v0, v1;
+            deinterleave(data + i * 2, v0, v1);
+            uint32_t sum = DELTA * ROUNDS;
+            for (uint32_t round = 0; round < ROUNDS; ++round) {
+                v1 = sub(v1, bit_xor(add(bit_xor(shl_by<4>(v0), shr_by<5>(v0)), v0), U32Vec::broadcast(sum + key[(sum >> 11) & 3])));
+                sum -= DELTA;
+                v0 = sub(v0, bit_xor(add(bit_xor(shl_by<4>(v1), shr_by<5>(v1)), v1), U32Vec::broadcast(sum + key[sum & 3])));
+            }
+            interleave(v0, v1, data + i * 2);
+        }
+        return i;
+    }
+#endif
 };
 class AESLikeCipher {
 public:
+    static constexpr const char* NAME = "AESLikeCipher";
     static constexpr uint32_t ROUNDS = 8;
     static constexpr uint32_t rotate_left(uint32_t x, int bits) {
         return (x << bits) | (x >> (32 - bits));
@@ -77,36 +181,208 @@ public:
             v0 = temp;
         }
     }
+    static constexpr size_t BATCH_BLOCKS = core::simd::U32Vec::WIDTH;
     static constexpr void encrypt_buffer(uint32_t* data, size_t num_blocks, const uint32_t* key) {
-        for (size_t i = 0; i < num_blocks; ++i) {
+        size_t i = 0;
+        if (!std::is_constant_evaluated()) {
+            i = encrypt_vectors(data, num_blocks, key);
+        }
+        for (; i < num_blocks; ++i) {
             encrypt(data[i * 2], data[i * 2 + 1], key);
         }
     }
     static constexpr void decrypt_buffer(uint32_t* data, size_t num_blocks, const uint32_t* key) {
-        for (size_t i = 0; i < num_blocks; ++i) {
+        size_t i = 0;
+        if (!std::is_constant_evaluated()) {
+            i = decrypt_vectors(data, num_blocks, key);
+        }
+        for (; i < num_blocks; ++i) {
             decrypt(data[i * 2], data[i * 2 + 1], key);
         }
     }
+private:
+    static size_t encrypt_vectors(uint32_t* data, size_t num_blocks, const uint32_t* key) {
+        size_t i = 0;
+#if defined(VIVISECT_SIMD_AVX2_DISPATCH)
+        if (core::simd::has_avx2()) i = encrypt_avx2(data, num_blocks, key);
+#endif
+        if (core::simd::NATIVE_VECTORS) {
+            for (; i + BATCH_BLOCKS <= num_blocks; i += BATCH_BLOCKS) {
+                encrypt_batch(data + i * 2, key);
+            }
+        }
+        return i;
+    }
+    static size_t decrypt_vectors(uint32_t* data, size_t num_blocks, const uint32_t* key) {
+        size_t i = 0;
+#if defined(VIVISECT_SIMD_AVX2_DISPATCH)
+        if (core::simd::has_avx2()) i = decrypt_avx2(data, num_blocks, key);
+#endif
+        if (core::simd::NATIVE_VECTORS) {
+            for (; i + BATCH_BLOCKS <= num_blocks; i += BATCH_BLOCKS) {
+                decrypt_batch(data + i * 2, key);
+            }
+        }
+        return i;
+    }
+    static core::simd::U32Vec round_function(core::simd::U32Vec x, core::simd::U32Vec k) {
+        using namespace core::simd;
+        x = rotl_by<7>(bit_xor(x, k));
+        x = rotl_by<13>(bit_xor(x, U32Vec::broadcast(0x9E3779B9)));
+        return bit_xor(x, k);
+    }
+    static void encrypt_batch(uint32_t* data, const uint32_t* key) {
+        using namespace core::simd;
+        U32Vec v0, v1;
+        deinterleave(data, v0, v1);
+        for (uint32_t round = 0; round < ROUNDS; ++round) {
+            const U32Vec temp = v0;
+            v0 = bit_xor(v1, round_function(v0, U32Vec::broadcast(key[round % 4])));
+            v1 = temp;
+        }
+        interleave(v1, v0, data);
+    }
+    static void decrypt_batch(uint32_t* data, const uint32_t* key) {
+        using namespace core::simd;
+        U32Vec v0, v1;
+        deinterleave(data, v1, v0);
+        for (uint32_t round = ROUNDS; round > 0; --round) {
+            const U32Vec temp = v1;
+            v1 = bit_xor(v0, round_function(v1, U32Vec::broadcast(key[(round - 1) % 4])));
+            v0 = temp;
+        }
+        interleave(v0, v1, data);
+    }
+#if defined(VIVISECT_SIMD_AVX2_DISPATCH)
+    VIVISECT_SIMD_AVX2_TARGET static core::simd::avx2::U32Vec round_function(core::simd::avx2::U32Vec x, core::simd::avx2::U32Vec k) {
+        using namespace core::simd::avx2;
+        x = rotl_by<7>(bit_xor(x, k));
+        x = rotl_by<13>(bit_xor(x, U32Vec::broadcast(0x9E3779B9)));
+        return bit_xor(x, k);
+    }
+    VIVISECT_SIMD_AVX2_TARGET static size_t encrypt_avx2(uint32_t* data, size_t num_blocks, const uint32_t* key) {
+        using namespace core::simd::avx2;
+        size_t i = 0;
+        for (; i + U32Vec::WIDTH <= num_blocks; i += U32Vec::WIDTH) {
+            U32Vec v0, v1;
+            deinterleave(data + i * 2, v0, v1);
+            for (uint32_t round = 0; round < ROUNDS; ++round) {
+                const U32Vec temp = v0;
+                v0 = bit_xor(v1, round_function(v0, U32Vec::broadcast(key[round % 4])));
+                v1 = temp;
+            }
+            interleave(v1, v0, data + i * 2);
+        }
+        return i;
+    }
+    VIVISECT_SIMD_AVX2_TARGET static size_t decrypt_avx2(uint32_t* data, size_t num_blocks, const uint32_t* key) {
+        using namespace core::simd::avx2;
+        size_t i = 0;
+        for (; i + U32Vec::WIDTH <= num_blocks; i += U32Vec::WIDTH) {
+            U32Vec v0, v1;
+            deinterleave(data + i * 2, v1, v0);
+            for (uint32_t round = ROUNDS; round > 0; --round) {
+                const U32Vec temp = v1;
+                v1 = bit_xor(v0, round_function(v1, U32Vec::broadcast(key[(round - 1) % 4])));
+                v0 = temp;
+            }
+            interleave(v0, v1, data + i * 2);
+        }
+        return i;
+    }
+#endif
+};
+template<typename Cipher = XTEACipher>
+class CounterModeCipher {
+public:
+    using Key = std::array<uint32_t, 4>;
+    static constexpr size_t BLOCK_BYTES = 8;
+    static constexpr size_t CHUNK_BLOCKS = 64;
+    static constexpr size_t MIN_PARALLEL_BYTES = 64 * 1024;
+    constexpr CounterModeCipher(const Key& key, uint32_t nonce) : key_(key), nonce_(nonce) {}
+    void apply(uint8_t* data, size_t offset, size_t length) const {
+        uint32_t counters[CHUNK_BLOCKS * 2];
+        uint8_t stream[CHUNK_BLOCKS * BLOCK_BYTES];
+        size_t done = 0;
+        while (done < length) {
+            const size_t position = offset + done;
+            const uint64_t first = position / BLOCK_BYTES;
+            const size_t skip = position % BLOCK_BYTES;
+            size_t blocks = (skip + (length - done) + BLOCK_BYTES - 1) / BLOCK_BYTES;
+            if (blocks > CHUNK_BLOCKS) blocks = CHUNK_BLOCKS;
+            for (size_t b = 0; b < blocks; ++b) {
+                const uint64_t counter = first + b;
+                counters[b * 2] = static_cast<uint32_t>(counter);
+                counters[b * 2 + 1] = nonce_ ^ static_cast<uint32_t>(counter >> 32);
+            }
+            Cipher::encrypt_buffer(counters, blocks, key_.data());
+            if constexpr (std::endian::native == std::endian::little) {
+                std::memcpy(stream, counters, blocks * BLOCK_BYTES);
+            } else {
+                for (size_t w = 0; w < blocks * 2; ++w) {
+                    for (size_t k = 0; k < 4; ++k) {
+                        stream[w * 4 + k] = static_cast<uint8_t>(counters[w] >> (k * 8));
+                    }
+                }
+            }
+            size_t count = blocks * BLOCK_BYTES - skip;
+            if (count > length - done) count = length - done;
+            for (size_t k = 0; k < count; ++k) {
+                data[done + k] ^= stream[skip + k];
+            }
+            done += count;
+        }
+        core::secure_wipe(counters, sizeof(counters));
+        core::secure_wipe(stream, sizeof(stream));
+    }
+    void apply_parallel(uint8_t* data, size_t offset, size_t length, size_t thread_count = 0) const {
+        if (thread_count == 0) {
+            thread_count = std::thread::hardware_concurrency();
+            if (thread_count == 0) thread_count = 1;
+        }
+        if (thread_count > length / MIN_PARALLEL_BYTES) thread_count = length / MIN_PARALLEL_BYTES;
+        if (thread_count <= 1) {
+            apply(data, offset, length);
+            return;
+        }
+        const size_t slice = ((length / thread_count) + BLOCK_BYTES - 1) / BLOCK_BYTES * BLOCK_BYTES;
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count - 1);
+        for (size_t begin = slice; begin < length; begin += slice) {
+            const size_t count = (length - begin < slice) ? length - begin : slice;
+            try {
+                workers.emplace_back([this, data, offset, begin, count] {
+                    apply(data + begin, offset + begin, count);
+                });
+            } catch (const std::system_error&) {
+                apply(data + begin, offset + begin, count);
+            }
+        }
+        apply(data, offset, slice);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+    const Key& key() const { return key_; }
+    uint32_t nonce() const { return nonce_; }
+private:
+    Key key_;
+    uint32_t nonce_;
 };
 template<size_t N, typename Cipher = XTEACipher>
 class EncryptedString {
 public:
+    class Plaintext;
     constexpr EncryptedString(const char (&str)[N]) : original_length_(N - 1) {
         key_[0] = core::compile_time_seed() ^ __LINE__;
         key_[1] = core::mix_seed(key_[0], __COUNTER__);
         key_[2] = core::mix_seed(key_[1], N);
         key_[3] = core::mix_seed(key_[2], 0xDEADBEEF);
-        for (size_t i = 0; i < N; ++i) {
-            char_buffer_[i] = str[i];
-        }
-        for (size_t i = N; i < buffer_size_; ++i) {
-            char_buffer_[i] = 0;
-        }
         uint32_t temp_data[num_blocks_ * 2] = {};
-        for (size_t i = 0; i < buffer_size_; ++i) {
+        for (size_t i = 0; i < N; ++i) {
             size_t word_idx = i / 4;
             size_t byte_idx = i % 4;
-            temp_data[word_idx] |= (static_cast<uint32_t>(static_cast<uint8_t>(char_buffer_[i])) << (byte_idx * 8));
+            temp_data[word_idx] |= (static_cast<uint32_t>(static_cast<uint8_t>(str[i])) << (byte_idx * 8));
         }
         Cipher::encrypt_buffer(temp_data, num_blocks_, key_);
         for (size_t i = 0; i < num_blocks_ * 2; ++i) {
@@ -152,16 +428,202 @@ public:
         temp_buffer[original_length_] = '\0';
         return temp_buffer;
     }
+    Plaintext plaintext() const {
+        return Plaintext(*this);
+    }
+    template<typename Callback>
+    decltype(auto) with_plaintext(Callback&& callback) const {
+        const Plaintext plain(*this);
+        return std::forward<Callback>(callback)(plain.view());
+    }
     constexpr size_t length() const {
         return original_length_;
     }
 private:
+    template<size_t, typename>
+    friend class CachedString;
     static constexpr size_t buffer_size_ = ((N + 7) / 8) * 8;
     static constexpr size_t num_blocks_ = buffer_size_ / 8;
     uint32_t encrypted_data_[num_blocks_ * 2];
     uint32_t key_[4];
     size_t original_length_;
-    char char_buffer_[buffer_size_] = {};
+    void decrypt_blocks(uint32_t* out) const {
+        for (size_t i = 0; i < num_blocks_ * 2; ++i) {
+            out[i] = encrypted_data_[i];
+        }
+        Cipher::decrypt_buffer(out, num_blocks_, key_);
+        reinterpret_cast<char*>(out)[original_length_] = '\0';
+    }
+};
+template<size_t N, typename Cipher>
+class EncryptedString<N, Cipher>::Plaintext {
+public:
+    Plaintext(const Plaintext&) = delete;
+    Plaintext& operator=(const Plaintext&) = delete;
+    ~Plaintext() {
+        core::secure_wipe(data_, sizeof(data_));
+    }
+    std::string_view view() const {
+        return std::string_view(reinterpret_cast<const char*>(data_), length_);
+    }
+    const char* c_str() const {
+        return reinterpret_cast<const char*>(data_);
+    }
+    size_t size() const {
+        return length_;
+    }
+private:
+    friend class EncryptedString;
+    explicit Plaintext(const EncryptedString& source) : length_(source.original_length_) {
+        source.decrypt_blocks(data_);
+    }
+    uint32_t data_[num_blocks_ * 2];
+    size_t length_;
+};
+template<size_t N, typename Cipher = XTEACipher>
+class CachedString {
+public:
+    using Clock = std::chrono::steady_clock;
+    class Lease;
+    constexpr CachedString(const char (&str)[N]) : encrypted_(str) {}
+    CachedString(const CachedString&) = delete;
+    CachedString& operator=(const CachedString&) = delete;
+    ~CachedString() {
+        wipe();
+    }
+    std::string_view view() {
+        if ((state_.load(std::memory_order_acquire) & STATE_MASK) != READY ||
+            ttl_.load(std::memory_order_relaxed) > 0) {
+            decrypt_once();
+        }
+        return std::string_view(reinterpret_cast<const char*>(data_), N - 1);
+    }
+    const char* c_str() {
+        return view().data();
+    }
+    Lease lease() {
+        return Lease(*this);
+    }
+    void set_ttl(Clock::duration ttl) {
+        ttl_.store(ttl.count(), std::memory_order_relaxed);
+    }
+    bool is_cached() const {
+        return (state_.load(std::memory_order_acquire) & STATE_MASK) == READY;
+    }
+    void purge() {
+        for (;;) {
+            uint32_t expected = state_.load(std::memory_order_relaxed);
+            if (expected == EMPTY) return;
+            if ((expected & ~PURGE_PENDING) == READY) {
+                if (state_.compare_exchange_weak(expected, BUSY, std::memory_order_acquire)) {
+                    wipe();
+                    return;
+                }
+                continue;
+            }
+            if ((expected & STATE_MASK) == READY) {
+                if ((expected & PURGE_PENDING) ||
+                    state_.compare_exchange_weak(expected, expected | PURGE_PENDING, std::memory_order_relaxed)) {
+                    return;
+                }
+                continue;
+            }
+            std::this_thread::yield();
+        }
+    }
+    void purge_if_expired() {
+        if (expired()) purge();
+    }
+private:
+    static constexpr uint32_t EMPTY = 0;
+    static constexpr uint32_t BUSY = 1;
+    static constexpr uint32_t READY = 2;
+    static constexpr uint32_t STATE_MASK = 3;
+    static constexpr uint32_t PURGE_PENDING = 4;
+    static constexpr uint32_t READER = 8;
+    EncryptedString<N, Cipher> encrypted_;
+    std::atomic<uint32_t> state_{EMPTY};
+    std::atomic<int64_t> ttl_{0};
+    std::atomic<int64_t> decrypted_at_{0};
+    uint32_t data_[((N + 7) / 8) * 2] = {};
+    static int64_t now() {
+        return Clock::now().time_since_epoch().count();
+    }
+    bool expired() const {
+        const int64_t ttl = ttl_.load(std::memory_order_relaxed);
+        return ttl > 0 && now() - decrypted_at_.load(std::memory_order_relaxed) >= ttl;
+    }
+    void fill(uint32_t next_state) {
+        encrypted_.decrypt_blocks(data_);
+        decrypted_at_.store(now(), std::memory_order_relaxed);
+        state_.store(next_state, std::memory_order_release);
+    }
+    void wipe() {
+        core::secure_wipe(data_, sizeof(data_));
+        state_.store(EMPTY, std::memory_order_release);
+    }
+    void decrypt_once() {
+        for (;;) {
+            uint32_t expected = state_.load(std::memory_order_acquire);
+            if (expected == EMPTY || (expected == READY && expired())) {
+                if (state_.compare_exchange_weak(expected, BUSY, std::memory_order_acquire)) {
+                    fill(READY);
+                    return;
+                }
+                continue;
+            }
+            if ((expected & STATE_MASK) == READY) return;
+            std::this_thread::yield();
+        }
+    }
+    void acquire() {
+        for (;;) {
+            uint32_t expected = state_.load(std::memory_order_relaxed);
+            if (expected == EMPTY || (expected == READY && expired())) {
+                if (state_.compare_exchange_weak(expected, BUSY, std::memory_order_acquire)) {
+                    fill(READY + READER);
+                    return;
+                }
+                continue;
+            }
+            if ((expected & STATE_MASK) == READY &&
+                state_.compare_exchange_weak(expected, expected + READER, std::memory_order_acquire)) {
+                return;
+            }
+            if ((expected & STATE_MASK) == BUSY) std::this_thread::yield();
+        }
+    }
+    void release() {
+        uint32_t remaining = state_.fetch_sub(READER, std::memory_order_acq_rel) - READER;
+        if (remaining == (READY | PURGE_PENDING) &&
+            state_.compare_exchange_strong(remaining, BUSY, std::memory_order_acquire)) {
+            wipe();
+        }
+    }
+};
+template<size_t N, typename Cipher>
+class CachedString<N, Cipher>::Lease {
+public:
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+    ~Lease() {
+        cache_.release();
+    }
+    std::string_view view() const {
+        return std::string_view(reinterpret_cast<const char*>(cache_.data_), N - 1);
+    }
+    const char* c_str() const {
+        return reinterpret_cast<const char*>(cache_.data_);
+    }
+    size_t size() const {
+        return N - 1;
+    }
+private:
+    friend class CachedString;
+    explicit Lease(CachedString& cache) : cache_(cache) {
+        cache_.acquire();
+    }
+    CachedString& cache_;
 };
 #ifdef _WIN32
 #define VIVISECT_STR_SECTION(str, section_name) \
@@ -188,5 +650,21 @@ private:
     vivisect::modules::EncryptedString<sizeof(str), vivisect::modules::AESLikeCipher>(str).decrypt()
 #define VIVISECT_CSTR(str) \
     vivisect::modules::EncryptedString<sizeof(str)>(str).c_str()
+#define VIVISECT_STR_SCOPED(str) \
+    vivisect::modules::EncryptedString<sizeof(str)>(str).plaintext()
+#define VIVISECT_STR_WITH(str, callback) \
+    vivisect::modules::EncryptedString<sizeof(str)>(str).with_plaintext(callback)
+#define VIVISECT_STR_CACHE(str) \
+    ([]() -> vivisect::modules::CachedString<sizeof(str)>& { \
+        static constinit vivisect::modules::CachedString<sizeof(str)> cache(str); \
+        return cache; \
+    }())
+#define VIVISECT_STR_CACHE_TLS(str) \
+    ([]() -> vivisect::modules::CachedString<sizeof(str)>& { \
+        constinit thread_local vivisect::modules::CachedString<sizeof(str)> cache(str); \
+        return cache; \
+    }())
+#define VIVISECT_STR_CACHED(str) VIVISECT_STR_CACHE(str).view()
+#define VIVISECT_STR_CACHED_TLS(str) VIVISECT_STR_CACHE_TLS(str).view()
 } 
 #endif 
\ No newline at end of file
@@ -0,0 +1,132 @@
+#ifndef VIVISECT_MODULES_VM_ASSEMBLER_HPP
+#define VIVISECT_MODULES_VM_ASSEMBLER_HPP
+#include <cstdint>
+#include <array>
+#include <string_view>
+#include "vm_engine.hpp"
+namespace vivisect::modules {
+enum class VMAsmItemKind : uint8_t {
+    INSTRUCTION,
+    LABEL
+};
+struct VMAsmItem {
+    VMAsmItemKind kind = VMAsmItemKind::INSTRUCTION;
+    VMOpcode opcode = VMOpcode::NOP;
+    uint8_t dest_reg = 0;
+    uint8_t src1_reg = 0;
+    uint8_t src2_reg = 0;
+    uint32_t immediate = 0;
+    std::string_view label;
+};
+namespace vm_asm {
+constexpr VMAsmItem label(std::string_view name) {
+    VMAsmItem item;
+    item.kind = VMAsmItemKind::LABEL;
+    item.label = name;
+    return item;
+}
+constexpr VMAsmItem op(VMOpcode opcode, uint8_t dest = 0, uint8_t src1 = 0, uint8_t src2 = 0, uint32_t imm = 0) {
+    VMAsmItem item;
+    item.opcode = opcode;
+    item.dest_reg = dest;
+    item.src1_reg = src1;
+    item.src2_reg = src2;
+    item.immediate = imm;
+    return item;
+}
+constexpr VMAsmItem branch(VMOpcode opcode, uint8_t src1, std::string_view target) {
+    VMAsmItem item = op(opcode, 0, src1);
+    item.label = target;
+    return item;
+}
+constexpr VMAsmItem add(uint8_t d, uint8_t a, uint8_t b) { return op(VMOpcode::ADD, d, a, b); }
+constexpr VMAsmItem sub(uint8_t d, uint8_t a, uint8_t b) { return op(VMOpcode::SUB, d, a, b); }
+constexpr VMAsmItem mul(uint8_t d, uint8_t a, uint8_t b) { return op(VMOpcode::MUL, d, a, b); }
+constexpr VMAsmItem div(uint8_t d, uint8_t a, uint8_t b) { return op(VMOpcode::DIV, d, a, b); }
+constexpr VMAsmItem xor_op(uint8_t d, uint8_t a, uint8_t b) { return op(VMOpcode::XOR, d, a, b); }
+constexpr VMAsmItem and_op(uint8_t d, uint8_t a, uint8_t b) { return op(VMOpcode::AND, d, a, b); }
+constexpr VMAsmItem or_op(uint8_t d, uint8_t a, uint8_t b) { return op(VMOpcode::OR, d, a, b); }
+constexpr VMAsmItem not_op(uint8_t d, uint8_t a) { return op(VMOpcode::NOT, d, a); }
+constexpr VMAsmItem shl(uint8_t d, uint8_t a, uint8_t b) { return op(VMOpcode::SHL, d, a, b); }
+constexpr VMAsmItem shr(uint8_t d, uint8_t a, uint8_t b) { return op(VMOpcode::SHR, d, a, b); }
+constexpr VMAsmItem load(uint8_t d, uint8_t addr) { return op(VMOpcode::LOAD, d, addr); }
+constexpr VMAsmItem store(uint8_t addr, uint8_t value) { return op(VMOpcode::STORE, addr, value); }
+constexpr VMAsmItem load_imm(uint8_t d, uint32_t imm) { return op(VMOpcode::LOAD_IMM, d, 0, 0, imm); }
+constexpr VMAsmItem jump(std::string_view target) { return branch(VMOpcode::JUMP, 0, target); }
+constexpr VMAsmItem jump_if_zero(uint8_t r, std::string_view target) { return branch(VMOpcode::JUMP_IF_ZERO, r, target); }
+constexpr VMAsmItem jump_if_not_zero(uint8_t r, std::string_view target) { return branch(VMOpcode::JUMP_IF_NOT_ZERO, r, target); }
+constexpr VMAsmItem call(std::string_view target) { return branch(VMOpcode::CALL, 0, target); }
+constexpr VMAsmItem ret() { return op(VMOpcode::RET); }
+constexpr VMAsmItem mangle_key(uint8_t d, uint8_t a) { return op(VMOpcode::MANGLE_KEY, d, a); }
+constexpr VMAsmItem junk_op() { return op(VMOpcode::JUNK_OP); }
+constexpr VMAsmItem nop() { return op(VMOpcode::NOP); }
+constexpr VMAsmItem host_call(uint8_t d, uint8_t first_arg, uint32_t id) { return op(VMOpcode::HOST_CALL, d, first_arg, 0, id); }
+}
+namespace detail {
+inline void vm_asm_invalid_register() {}
+inline void vm_asm_invalid_opcode() {}
+inline void vm_asm_duplicate_label() {}
+inline void vm_asm_undefined_label() {}
+inline void vm_asm_invalid_jump_target() {}
+}
+struct VMAssembler {
+    template<typename Source>
+    static consteval auto assemble(Source) {
+        constexpr auto items = Source{}();
+        constexpr size_t N = count_instructions(items);
+        static_assert(N > 0, "VM: Assembled program contains no instructions");
+        VMStaticProgram<N> program;
+        size_t pc = 0;
+        for (const VMAsmItem& item : items) {
+            if (item.kind == VMAsmItemKind::LABEL) {
+                if (resolve(items, item.label) != pc) {
+                    detail::vm_asm_duplicate_label();
+                }
+                continue;
+            }
+            if (item.dest_reg >= 8 || item.src1_reg >= 8 || item.src2_reg >= 8) {
+                detail::vm_asm_invalid_register();
+            }
+            if (static_cast<size_t>(item.opcode) >= VMProgram::MAX_OPCODE_SLOTS) {
+                detail::vm_asm_invalid_opcode();
+            }
+            uint32_t immediate = item.immediate;
+            if (VMBuiltinHandlers::has_branch_target(item.opcode)) {
+                if (!item.label.empty()) {
+                    immediate = static_cast<uint32_t>(resolve(items, item.label));
+                }
+                if (immediate > N) {
+                    detail::vm_asm_invalid_jump_target();
+                }
+            }
+            program.code_[pc++] = VMDecodedInstruction{
+                static_cast<uint16_t>(item.opcode), item.dest_reg, item.src1_reg, item.src2_reg, 0, {}, immediate
+            };
+        }
+        return program;
+    }
+private:
+    template<size_t M>
+    static constexpr size_t count_instructions(const std::array<VMAsmItem, M>& items) {
+        size_t count = 0;
+        for (const VMAsmItem& item : items) {
+            if (item.kind == VMAsmItemKind::INSTRUCTION) ++count;
+        }
+        return count;
+    }
+    template<size_t M>
+    static constexpr size_t resolve(const std::array<VMAsmItem, M>& items, std::string_view name) {
+        size_t pc = 0;
+        for (const VMAsmItem& item : items) {
+            if (item.kind == VMAsmItemKind::INSTRUCTION) {
+                ++pc;
+            } else if (item.label == name) {
+                return pc;
+            }
+        }
+        detail::vm_asm_undefined_label();
+        return pc;
+    }
+};
+}
+#endif
@@ -0,0 +1,428 @@
+#ifndef VIVISECT_MODULES_VM_CFG_HPP
+#define VIVISECT_MODULES_VM_CFG_HPP
+#include <cstdint>
+#include <array>
+#include <vector>
+#include "vm_engine.hpp"
+namespace vivisect::modules {
+struct VMBasicBlock {
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    bool exits = false;
+    bool reachable = false;
+    std::vector<uint32_t> successors;
+    std::vector<uint32_t> predecessors;
+};
+class VMControlFlowGraph {
+public:
+    static VMControlFlowGraph build(const VMProgram& program) {
+        return build(program.data(), program.size());
+    }
+    const std::vector<VMBasicBlock>& blocks() const { return blocks_; }
+    uint32_t block_of(uint32_t pc) const { return block_index_[pc]; }
+    size_t reachable_count() const {
+        size_t count = 0;
+        for (const VMBasicBlock& block : blocks_) {
+            if (block.reachable) ++count;
+        }
+        return count;
+    }
+private:
+    friend class VMDeadCodeEliminator;
+    std::vector<VMBasicBlock> blocks_;
+    std::vector<uint32_t> block_index_;
+    static bool has_target(const VMDecodedInstruction& inst) {
+        if (inst.opcode == static_cast<uint16_t>(VMFusedOpcode::ALU_JUMP_IF_ZERO) ||
+            inst.opcode == static_cast<uint16_t>(VMFusedOpcode::ALU_JUMP_IF_NOT_ZERO)) {
+            return true;
+        }
+        return inst.opcode < VMProgram::MAX_OPCODE_SLOTS &&
+               VMBuiltinHandlers::has_branch_target(static_cast<VMOpcode>(inst.opcode));
+    }
+    static bool ends_block(const VMDecodedInstruction& inst) {
+        return has_target(inst) || inst.opcode == static_cast<uint16_t>(VMOpcode::RET);
+    }
+    static bool falls_through(const VMDecodedInstruction& inst) {
+        return inst.opcode != static_cast<uint16_t>(VMOpcode::JUMP) &&
+               inst.opcode != static_cast<uint16_t>(VMOpcode::CALL) &&
+               inst.opcode != static_cast<uint16_t>(VMOpcode::RET);
+    }
+    static VMControlFlowGraph build(const VMDecodedInstruction* code, size_t length) {
+        VMControlFlowGraph graph;
+        if (length == 0) return graph;
+        std::vector<bool> leader(length + 1, false);
+        std::vector<uint32_t> return_sites;
+        leader[0] = true;
+        for (size_t pc = 0; pc < length; ++pc) {
+            if (has_target(code[pc])) leader[code[pc].immediate] = true;
+            if (ends_block(code[pc])) leader[pc + 1] = true;
+            if (code[pc].opcode == static_cast<uint16_t>(VMOpcode::CALL)) {
+                return_sites.push_back(static_cast<uint32_t>(pc + 1));
+            }
+        }
+        graph.block_index_.assign(length, 0);
+        for (size_t pc = 0; pc < length; ++pc) {
+            if (leader[pc]) {
+                VMBasicBlock block;
+                block.begin = static_cast<uint32_t>(pc);
+                graph.blocks_.push_back(block);
+            }
+            graph.blocks_.back().end = static_cast<uint32_t>(pc + 1);
+            graph.block_index_[pc] = static_cast<uint32_t>(graph.blocks_.size() - 1);
+        }
+        for (size_t b = 0; b < graph.blocks_.size(); ++b) {
+            VMBasicBlock& block = graph.blocks_[b];
+            const VMDecodedInstruction& last = code[block.end - 1];
+            auto link = [&](uint32_t pc) {
+                if (pc >= length) {
+                    block.exits = true;
+                    return;
+                }
+                const uint32_t target = graph.block_index_[pc];
+                for (uint32_t existing : block.successors) {
+                    if (existing == target) return;
+                }
+                block.successors.push_back(target);
+            };
+            if (has_target(last)) link(last.immediate);
+            if (last.opcode == static_cast<uint16_t>(VMOpcode::RET)) {
+                for (uint32_t site : return_sites) link(site);
+            }
+            if (falls_through(last)) link(block.end);
+        }
+        for (size_t b = 0; b < graph.blocks_.size(); ++b) {
+            for (uint32_t successor : graph.blocks_[b].successors) {
+                graph.blocks_[successor].predecessors.push_back(static_cast<uint32_t>(b));
+            }
+        }
+        std::vector<uint32_t> worklist{0};
+        graph.blocks_[0].reachable = true;
+        while (!worklist.empty()) {
+            const uint32_t b = worklist.back();
+            worklist.pop_back();
+            for (uint32_t successor : graph.blocks_[b].successors) {
+                if (!graph.blocks_[successor].reachable) {
+                    graph.blocks_[successor].reachable = true;
+                    worklist.push_back(successor);
+                }
+            }
+        }
+        return graph;
+    }
+};
+struct VMDeadCodeReport {
+    size_t instructions_before = 0;
+    size_t instructions_after = 0;
+    size_t dead_stores = 0;
+    size_t folded_constants = 0;
+    size_t folded_branches = 0;
+    size_t unreachable_instructions = 0;
+};
+class VMDeadCodeEliminator {
+public:
+    static constexpr size_t MAX_ROUNDS = 16;
+    static VMProgram optimize(const VMProgram& program, VMDeadCodeReport* report = nullptr) {
+        VMDeadCodeReport counts;
+        counts.instructions_before = program.size();
+        std::vector<VMDecodedInstruction> code(program.data(), program.data() + program.size());
+        bool supported = true;
+        for (const VMDecodedInstruction& inst : code) {
+            if (inst.opcode >= VMProgram::MAX_OPCODE_SLOTS) supported = false;
+        }
+        for (size_t round = 0; supported && !code.empty() && round < MAX_ROUNDS; ++round) {
+            if (!run_round(code, counts)) break;
+        }
+        VMProgram result;
+        result.code_ = std::move(code);
+        if (result.code_.empty()) {
+            result.code_.push_back(VMDecodedInstruction{
+                static_cast<uint16_t>(VMOpcode::NOP), 0, 0, 0, 0, {}, 0
+            });
+        }
+        counts.instructions_after = result.code_.size();
+        if (report) *report = counts;
+        return result;
+    }
+private:
+    static constexpr uint16_t FLAGS = uint16_t(1) << 8;
+    static constexpr uint16_t ALL_REGISTERS = 0xFF;
+    static constexpr uint16_t ALL_STATE = ALL_REGISTERS | FLAGS;
+    struct Effect {
+        uint16_t uses = 0;
+        uint16_t defs = 0;
+        uint16_t may_defs = 0;
+        bool removable = false;
+    };
+    struct Constants {
+        bool valid = false;
+        uint8_t known = 0;
+        std::array<uint32_t, 8> values{};
+    };
+    static uint16_t bit(uint8_t reg) { return static_cast<uint16_t>(1u << reg); }
+    static VMOpcode opcode_of(const VMDecodedInstruction& inst) {
+        return static_cast<VMOpcode>(inst.opcode);
+    }
+    static Effect effect_of(const VMDecodedInstruction& inst) {
+        Effect effect;
+        const VMOpcode op = opcode_of(inst);
+        if (VMBuiltinHandlers::is_fusable_alu(op)) {
+            effect.uses = bit(inst.src1_reg);
+            if (op != VMOpcode::NOT) effect.uses |= bit(inst.src2_reg);
+            effect.defs = bit(inst.dest_reg) | FLAGS;
+            effect.removable = true;
+            return effect;
+        }
+        switch (op) {
+            case VMOpcode::DIV:
+                effect.uses = bit(inst.src1_reg) | bit(inst.src2_reg);
+                effect.may_defs = bit(inst.dest_reg) | FLAGS;
+                effect.removable = true;
+                break;
+            case VMOpcode::LOAD:
+                effect.uses = bit(inst.src1_reg);
+                effect.may_defs = bit(inst.dest_reg);
+                effect.removable = true;
+                break;
+            case VMOpcode::LOAD_IMM:
+                effect.defs = bit(inst.dest_reg);
+                effect.removable = true;
+                break;
+            case VMOpcode::MANGLE_KEY:
+                effect.uses = bit(inst.src1_reg);
+                effect.defs = bit(inst.dest_reg);
+                effect.removable = true;
+                break;
+            case VMOpcode::STORE:
+                effect.uses = bit(inst.dest_reg) | bit(inst.src1_reg);
+                break;
+            case VMOpcode::JUMP_IF_ZERO:
+            case VMOpcode::JUMP_IF_NOT_ZERO:
+                effect.uses = bit(inst.src1_reg);
+                break;
+            case VMOpcode::HOST_CALL:
+                effect.uses = ALL_REGISTERS;
+                effect.may_defs = bit(inst.dest_reg);
+                break;
+            case VMOpcode::JUMP:
+            case VMOpcode::CALL:
+            case VMOpcode::RET:
+            case VMOpcode::JUNK_OP:
+            case VMOpcode::NOP:
+                break;
+            default:
+                effect.uses = ALL_STATE;
+                effect.may_defs = ALL_STATE;
+                break;
+        }
+        return effect;
+    }
+    static void meet(Constants& into, const Constants& from) {
+        if (!from.valid) return;
+        if (!into.valid) {
+            into = from;
+            return;
+        }
+        for (uint8_t reg = 0; reg < 8; ++reg) {
+            if ((into.known & bit(reg)) && (!(from.known & bit(reg)) || into.values[reg] != from.values[reg])) {
+                into.known &= static_cast<uint8_t>(~bit(reg));
+            }
+        }
+    }
+    static bool fold(const VMDecodedInstruction& inst, const Constants& in, uint32_t& result) {
+        const VMOpcode op = opcode_of(inst);
+        const bool a_known = in.known & bit(inst.src1_reg);
+        const bool b_known = in.known & bit(inst.src2_reg);
+        const uint32_t a = in.values[inst.src1_reg];
+        const uint32_t b = in.values[inst.src2_reg];
+        if (op == VMOpcode::NOT) {
+            if (!a_known) return false;
+            result = ~a;
+            return true;
+        }
+        if (op == VMOpcode::DIV) {
+            if (!a_known || !b_known || b == 0) return false;
+            result = a / b;
+            return true;
+        }
+        if (!VMBuiltinHandlers::is_fusable_alu(op) || !a_known || !b_known) return false;
+        result = VMBuiltinHandlers::alu(static_cast<uint8_t>(op), a, b);
+        return true;
+    }
+    static void transfer(const VMDecodedInstruction& inst, Constants& state) {
+        const VMOpcode op = opcode_of(inst);
+        uint32_t value = 0;
+        if (op == VMOpcode::LOAD_IMM) {
+            state.known |= static_cast<uint8_t>(bit(inst.dest_reg));
+            state.values[inst.dest_reg] = inst.immediate;
+        } else if (op == VMOpcode::DIV && (state.known & bit(inst.src2_reg)) && state.values[inst.src2_reg] == 0) {
+            return;
+        } else if (fold(inst, state, value)) {
+            state.known |= static_cast<uint8_t>(bit(inst.dest_reg));
+            state.values[inst.dest_reg] = value;
+        } else {
+            const Effect effect = effect_of(inst);
+            state.known &= static_cast<uint8_t>(~((effect.defs | effect.may_defs) & ALL_REGISTERS));
+        }
+    }
+    static std::vector<Constants> propagate(const std::vector<VMDecodedInstruction>& code, const VMControlFlowGraph& graph) {
+        const std::vector<VMBasicBlock>& blocks = graph.blocks_;
+        std::vector<Constants> entry(blocks.size());
+        entry[0].valid = true;
+        std::vector<uint32_t> worklist{0};
+        std::vector<bool> queued(blocks.size(), false);
+        queued[0] = true;
+        while (!worklist.empty()) {
+            const uint32_t b = worklist.back();
+            worklist.pop_back();
+            queued[b] = false;
+            Constants state = entry[b];
+            for (uint32_t pc = blocks[b].begin; pc < blocks[b].end; ++pc) {
+                transfer(code[pc], state);
+            }
+            for (uint32_t successor : blocks[b].successors) {
+                Constants merged = entry[successor];
+                meet(merged, state);
+                if (merged.valid != entry[successor].valid || merged.known != entry[successor].known) {
+                    entry[successor] = merged;
+                    if (!queued[successor]) {
+                        queued[successor] = true;
+                        worklist.push_back(successor);
+                    }
+                }
+            }
+        }
+        return entry;
+    }
+    static std::vector<uint16_t> liveness(const std::vector<VMDecodedInstruction>& code, const VMControlFlowGraph& graph) {
+        const std::vector<VMBasicBlock>& blocks = graph.blocks_;
+        std::vector<uint16_t> live_in(blocks.size(), 0);
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (size_t b = blocks.size(); b-- > 0;) {
+                uint16_t live = blocks[b].exits ? ALL_STATE : 0;
+                for (uint32_t successor : blocks[b].successors) live |= live_in[successor];
+                for (uint32_t pc = blocks[b].end; pc-- > blocks[b].begin;) {
+                    const Effect effect = effect_of(code[pc]);
+                    live = static_cast<uint16_t>((live & ~effect.defs) | effect.uses);
+                }
+                if (live != live_in[b]) {
+                    live_in[b] = live;
+                    changed = true;
+                }
+            }
+        }
+        return live_in;
+    }
+    static std::vector<uint16_t> live_after(const std::vector<VMDecodedInstruction>& code,
+                                            const VMBasicBlock& block, const std::vector<uint16_t>& live_in) {
+        uint16_t live = block.exits ? ALL_STATE : 0;
+        for (uint32_t successor : block.successors) live |= live_in[successor];
+        std::vector<uint16_t> result(block.end - block.begin);
+        for (uint32_t pc = block.end; pc-- > block.begin;) {
+            result[pc - block.begin] = live;
+            const Effect effect = effect_of(code[pc]);
+            live = static_cast<uint16_t>((live & ~effect.defs) | effect.uses);
+        }
+        return result;
+    }
+    static bool fold_constants(std::vector<VMDecodedInstruction>& code, const VMControlFlowGraph& graph,
+                               const std::vector<uint16_t>& live_in, std::vector<bool>& keep,
+                               VMDeadCodeReport& counts) {
+        const std::vector<VMBasicBlock>& blocks = graph.blocks_;
+        const std::vector<Constants> constants = propagate(code, graph);
+        bool changed = false;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            const VMBasicBlock& block = blocks[b];
+            if (!block.reachable) {
+                for (uint32_t pc = block.begin; pc < block.end; ++pc) keep[pc] = false;
+                counts.unreachable_instructions += block.end - block.begin;
+                changed = true;
+                continue;
+            }
+            const std::vector<uint16_t> after = live_after(code, block, live_in);
+            Constants state = constants[b];
+            for (uint32_t pc = block.begin; pc < block.end; ++pc) {
+                VMDecodedInstruction& inst = code[pc];
+                const VMOpcode op = opcode_of(inst);
+                uint32_t value = 0;
+                if (op == VMOpcode::LOAD_IMM && (state.known & bit(inst.dest_reg)) &&
+                    state.values[inst.dest_reg] == inst.immediate) {
+                    keep[pc] = false;
+                    ++counts.folded_constants;
+                    changed = true;
+                } else if (op != VMOpcode::LOAD_IMM && !(after[pc - block.begin] & FLAGS) && fold(inst, state, value)) {
+                    inst = VMDecodedInstruction{
+                        static_cast<uint16_t>(VMOpcode::LOAD_IMM), inst.dest_reg, 0, 0, 0, {}, value
+                    };
+                    ++counts.folded_constants;
+                    changed = true;
+                } else if ((op == VMOpcode::JUMP_IF_ZERO || op == VMOpcode::JUMP_IF_NOT_ZERO) &&
+                           (state.known & bit(inst.src1_reg))) {
+                    const bool taken = (state.values[inst.src1_reg] == 0) == (op == VMOpcode::JUMP_IF_ZERO);
+                    if (taken) {
+                        inst.opcode = static_cast<uint16_t>(VMOpcode::JUMP);
+                        inst.src1_reg = 0;
+                    } else {
+                        keep[pc] = false;
+                    }
+                    ++counts.folded_branches;
+                    changed = true;
+                } else if ((op == VMOpcode::JUMP || op == VMOpcode::JUMP_IF_ZERO || op == VMOpcode::JUMP_IF_NOT_ZERO) &&
+                           inst.immediate == pc + 1) {
+                    keep[pc] = false;
+                    ++counts.folded_branches;
+                    changed = true;
+                }
+                transfer(inst, state);
+            }
+        }
+        return changed;
+    }
+    static bool remove_dead_stores(const std::vector<VMDecodedInstruction>& code, const VMControlFlowGraph& graph,
+                                   const std::vector<uint16_t>& live_in, std::vector<bool>& keep,
+                                   VMDeadCodeReport& counts) {
+        bool changed = false;
+        for (const VMBasicBlock& block : graph.blocks_) {
+            const std::vector<uint16_t> after = live_after(code, block, live_in);
+            for (uint32_t pc = block.begin; pc < block.end; ++pc) {
+                const Effect effect = effect_of(code[pc]);
+                if (effect.removable && ((effect.defs | effect.may_defs) & after[pc - block.begin]) == 0) {
+                    keep[pc] = false;
+                    ++counts.dead_stores;
+                    changed = true;
+                }
+            }
+        }
+        return changed;
+    }
+    static bool run_round(std::vector<VMDecodedInstruction>& code, VMDeadCodeReport& counts) {
+        const VMControlFlowGraph graph = VMControlFlowGraph::build(code.data(), code.size());
+        const std::vector<uint16_t> live_in = liveness(code, graph);
+        std::vector<bool> keep(code.size(), true);
+        bool changed = fold_constants(code, graph, live_in, keep, counts);
+        if (!changed) changed = remove_dead_stores(code, graph, live_in, keep, counts);
+        if (changed) compact(code, keep);
+        return changed;
+    }
+    static void compact(std::vector<VMDecodedInstruction>& code, const std::vector<bool>& keep) {
+        std::vector<uint32_t> new_index(code.size() + 1, 0);
+        uint32_t next = 0;
+        for (size_t pc = 0; pc < code.size(); ++pc) {
+            new_index[pc] = next;
+            if (keep[pc]) ++next;
+        }
+        new_index[code.size()] = next;
+        std::vector<VMDecodedInstruction> result;
+        result.reserve(next);
+        for (size_t pc = 0; pc < code.size(); ++pc) {
+            if (!keep[pc]) continue;
+            VMDecodedInstruction inst = code[pc];
+            if (VMControlFlowGraph::has_target(inst)) inst.immediate = new_index[inst.immediate];
+            result.push_back(inst);
+        }
+        code = std::move(result);
+    }
+};
+}
+#endif
@@ -0,0 +1,158 @@
+#ifndef VIVISECT_MODULES_VM_COMPILED_HPP
+#define VIVISECT_MODULES_VM_COMPILED_HPP
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <type_traits>
+#include <utility>
+#include "vm_engine.hpp"
+namespace vivisect::modules {
+namespace detail {
+template<size_t N>
+constexpr size_t vm_compiled_size(const VMStaticProgram<N>&) { return N; }
+template<size_t N>
+constexpr size_t vm_compiled_size(const VMBytecode<N>&) { return N; }
+template<size_t N>
+constexpr VMDecodedInstruction vm_compiled_instruction(const VMStaticProgram<N>& program, size_t pc) {
+    return program.data()[pc];
+}
+template<size_t N>
+constexpr VMDecodedInstruction vm_compiled_instruction(const VMBytecode<N>& bytecode, size_t pc) {
+    const VMInstruction& inst = bytecode.instructions[pc];
+    return VMDecodedInstruction{
+        static_cast<uint16_t>(inst.opcode), inst.dest_reg, inst.src1_reg, inst.src2_reg, 0, {}, inst.immediate
+    };
+}
+template<typename Program>
+constexpr bool vm_compiled_valid_registers(const Program& program) {
+    for (size_t pc = 0; pc < vm_compiled_size(program); ++pc) {
+        const VMDecodedInstruction inst = vm_compiled_instruction(program, pc);
+        if (inst.dest_reg >= 8 || inst.src1_reg >= 8 || inst.src2_reg >= 8) return false;
+    }
+    return true;
+}
+template<typename Program>
+constexpr bool vm_compiled_builtin_opcodes(const Program& program) {
+    for (size_t pc = 0; pc < vm_compiled_size(program); ++pc) {
+        if (vm_compiled_instruction(program, pc).opcode > static_cast<uint16_t>(VMOpcode::NOP)) return false;
+    }
+    return true;
+}
+template<typename Program>
+constexpr bool vm_compiled_valid_targets(const Program& program) {
+    for (size_t pc = 0; pc < vm_compiled_size(program); ++pc) {
+        const VMDecodedInstruction inst = vm_compiled_instruction(program, pc);
+        if (VMBuiltinHandlers::has_branch_target(static_cast<VMOpcode>(inst.opcode)) &&
+            inst.immediate > vm_compiled_size(program)) {
+            return false;
+        }
+    }
+    return true;
+}
+template<size_t N, typename Program>
+constexpr std::array<bool, N + 1> vm_compiled_leaders(const Program& program) {
+    std::array<bool, N + 1> leaders{};
+    leaders[0] = true;
+    for (size_t pc = 0; pc < N; ++pc) {
+        const VMDecodedInstruction inst = vm_compiled_instruction(program, pc);
+        const VMOpcode op = static_cast<VMOpcode>(inst.opcode);
+        if (VMBuiltinHandlers::is_control_flow(op)) leaders[pc + 1] = true;
+        if (VMBuiltinHandlers::has_branch_target(op) && inst.immediate <= N) leaders[inst.immediate] = true;
+    }
+    return leaders;
+}
+}
+template<const auto& Program>
+class VMCompiledProgram {
+public:
+    static constexpr size_t SIZE = detail::vm_compiled_size(Program);
+    static void execute(VMEngine& engine) {
+        VMState& state = engine.state_;
+        state.load_seed();
+        run(state);
+        state.store_seed();
+    }
+    static void run(VMState& state) {
+        static constexpr std::array<Entry, SIZE> entries = make_entries(std::make_index_sequence<SIZE>{});
+        uint32_t pc = run_block<0>(state);
+        while (pc < SIZE) {
+            pc = entries[pc](state);
+        }
+        state.pc = pc;
+    }
+    static constexpr const auto& source() { return Program; }
+    static constexpr size_t block_count() {
+        size_t count = 0;
+        for (size_t pc = 0; pc < SIZE; ++pc) {
+            if (LEADERS[pc]) ++count;
+        }
+        return count;
+    }
+private:
+    using Entry = uint32_t(*)(VMState&);
+    template<size_t PC>
+    static constexpr VMDecodedInstruction INSTRUCTION = detail::vm_compiled_instruction(Program, PC);
+    template<size_t PC>
+    static constexpr VMOpcode OPCODE = static_cast<VMOpcode>(INSTRUCTION<PC>.opcode);
+    static_assert(SIZE > 0, "VM: Compiled program contains no instructions");
+    static_assert(detail::vm_compiled_valid_registers(Program), "VM: Invalid register index");
+    static_assert(detail::vm_compiled_builtin_opcodes(Program), "VM: Compiled programs support builtin opcodes only");
+    static_assert(detail::vm_compiled_valid_targets(Program), "VM: Branch target outside program");
+    static constexpr std::array<bool, SIZE + 1> LEADERS = detail::vm_compiled_leaders<SIZE>(Program);
+    template<size_t PC>
+    static void execute_op(VMState& s) {
+        constexpr const VMDecodedInstruction& i = INSTRUCTION<PC>;
+        if constexpr (OPCODE<PC> == VMOpcode::ADD) VMBuiltinHandlers::add(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::SUB) VMBuiltinHandlers::sub(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::MUL) VMBuiltinHandlers::mul(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::DIV) VMBuiltinHandlers::div(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::XOR) VMBuiltinHandlers::xor_op(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::AND) VMBuiltinHandlers::and_op(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::OR) VMBuiltinHandlers::or_op(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::NOT) VMBuiltinHandlers::not_op(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::SHL) VMBuiltinHandlers::shl(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::SHR) VMBuiltinHandlers::shr(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::LOAD) VMBuiltinHandlers::load(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::STORE) VMBuiltinHandlers::store(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::LOAD_IMM) VMBuiltinHandlers::load_imm(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::JUMP) VMBuiltinHandlers::jump(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::JUMP_IF_ZERO) VMBuiltinHandlers::jump_if_zero(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::JUMP_IF_NOT_ZERO) VMBuiltinHandlers::jump_if_not_zero(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::CALL) VMBuiltinHandlers::call(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::RET) VMBuiltinHandlers::ret(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::MANGLE_KEY) VMBuiltinHandlers::mangle_key(s, i);
+        else if constexpr (OPCODE<PC> == VMOpcode::JUNK_OP) VMBuiltinHandlers::junk_op(s, i);
+        else VMBuiltinHandlers::nop(s, i);
+    }
+    template<size_t PC>
+    static uint32_t run_one(VMState& s) {
+        if constexpr (VMBuiltinHandlers::is_control_flow(OPCODE<PC>)) {
+            s.pc = static_cast<uint32_t>(PC);
+            execute_op<PC>(s);
+            return s.pc;
+        } else {
+            execute_op<PC>(s);
+            return static_cast<uint32_t>(PC + 1);
+        }
+    }
+    template<size_t PC>
+    static uint32_t run_block(VMState& s) {
+        if constexpr (VMBuiltinHandlers::is_control_flow(OPCODE<PC>) || PC + 1 == SIZE || LEADERS[PC + 1]) {
+            return run_one<PC>(s);
+        } else {
+            execute_op<PC>(s);
+            return run_block<PC + 1>(s);
+        }
+    }
+    template<size_t PC>
+    static constexpr Entry entry() {
+        if constexpr (LEADERS[PC]) return &run_block<PC>;
+        else return &run_one<PC>;
+    }
+    template<size_t... PC>
+    static constexpr std::array<Entry, SIZE> make_entries(std::index_sequence<PC...>) {
+        return {{entry<PC>()...}};
+    }
+};
+}
+#endif
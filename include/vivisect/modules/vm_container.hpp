@@ -0,0 +1,396 @@
+#ifndef VIVISECT_MODULES_VM_CONTAINER_HPP
+#define VIVISECT_MODULES_VM_CONTAINER_HPP
+#include <cstdint>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "vm_engine.hpp"
+#include "vm_encrypted.hpp"
+#include "../error/error.hpp"
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+namespace vivisect::modules {
+enum class VMContainerKind : uint32_t {
+    PLAIN = 0,
+    ENCRYPTED = 1
+};
+struct VMContainerHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t instruction_size;
+    uint32_t routine_count;
+    uint32_t reserved;
+    uint64_t total_size;
+    uint64_t integrity;
+};
+struct VMContainerRoutine {
+    uint32_t name_hash;
+    VMContainerKind kind;
+    uint32_t instruction_count;
+    uint32_t nonce;
+    uint32_t code_offset;
+    uint32_t code_size;
+    uint32_t table_offset;
+    uint32_t table_count;
+};
+static_assert(sizeof(VMContainerHeader) == 32);
+static_assert(sizeof(VMContainerRoutine) == 32);
+struct VMContainerFormat {
+    static constexpr uint32_t MAGIC = 0x434D5656;
+    static constexpr uint16_t VERSION = 1;
+    static constexpr size_t ALIGNMENT = 8;
+    static constexpr uint32_t hash_name(std::string_view name) {
+        uint32_t hash = 0x811c9dc5;
+        for (char c : name) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 0x01000193;
+        }
+        return hash;
+    }
+    static uint64_t integrity(const uint8_t* data, size_t length) {
+        uint64_t lanes[4] = {0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL, 0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL};
+        size_t i = 0;
+        for (; i + 32 <= length; i += 32) {
+            for (size_t lane = 0; lane < 4; ++lane) {
+                uint64_t word;
+                std::memcpy(&word, data + i + lane * 8, sizeof(word));
+                lanes[lane] = (lanes[lane] ^ word) * 0x100000001b3ULL;
+                lanes[lane] ^= lanes[lane] >> 29;
+            }
+        }
+        for (; i + 8 <= length; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            lanes[0] = (lanes[0] ^ word) * 0x100000001b3ULL;
+            lanes[0] ^= lanes[0] >> 29;
+        }
+        uint64_t hash = length;
+        for (uint64_t lane : lanes) {
+            hash = (hash ^ lane) * 0x100000001b3ULL;
+            hash ^= hash >> 29;
+        }
+        return hash;
+    }
+    static constexpr size_t align(size_t offset) {
+        return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+};
+class VMContainerWriter {
+public:
+    void add(std::string_view name, const VMProgram& program) {
+        Entry entry;
+        entry.routine = VMContainerRoutine{VMContainerFormat::hash_name(name), VMContainerKind::PLAIN,
+                                           static_cast<uint32_t>(program.size()), 0, 0,
+                                           static_cast<uint32_t>(program.size() * sizeof(VMDecodedInstruction)), 0, 0};
+        entry.code.resize(entry.routine.code_size);
+        constexpr size_t padding = offsetof(VMDecodedInstruction, immediate) - sizeof(VMDecodedInstruction::fused_regs) -
+                                   offsetof(VMDecodedInstruction, fused_regs);
+        for (size_t pc = 0; pc < program.size(); ++pc) {
+            uint8_t* slot = entry.code.data() + pc * sizeof(VMDecodedInstruction);
+            std::memcpy(slot, &program.data()[pc], sizeof(VMDecodedInstruction));
+            std::memset(slot + offsetof(VMDecodedInstruction, immediate) - padding, 0, padding);
+        }
+        entries_.push_back(std::move(entry));
+    }
+    template<typename Cipher>
+    void add_encrypted(std::string_view name, const VMEncryptedProgram<Cipher>& program) {
+        Entry entry;
+        entry.routine = VMContainerRoutine{VMContainerFormat::hash_name(name), VMContainerKind::ENCRYPTED,
+                                           static_cast<uint32_t>(program.size()), program.nonce_, 0,
+                                           static_cast<uint32_t>(program.byte_count()), 0,
+                                           static_cast<uint32_t>(program.block_count())};
+        entry.code.assign(program.bytes(), program.bytes() + program.byte_count());
+        entry.table.assign(program.block_offsets(), program.block_offsets() + program.block_count());
+        entries_.push_back(std::move(entry));
+    }
+    std::vector<uint8_t> build() const {
+        size_t offset = VMContainerFormat::align(sizeof(VMContainerHeader) + entries_.size() * sizeof(VMContainerRoutine));
+        std::vector<VMContainerRoutine> routines;
+        routines.reserve(entries_.size());
+        for (const Entry& entry : entries_) {
+            VMContainerRoutine routine = entry.routine;
+            routine.code_offset = static_cast<uint32_t>(offset);
+            offset = VMContainerFormat::align(offset + entry.code.size());
+            if (routine.kind == VMContainerKind::ENCRYPTED) {
+                routine.table_offset = static_cast<uint32_t>(offset);
+                offset = VMContainerFormat::align(offset + entry.table.size() * sizeof(uint32_t));
+            }
+            routines.push_back(routine);
+        }
+        std::vector<uint8_t> image(offset, 0);
+        VMContainerHeader header{VMContainerFormat::MAGIC, VMContainerFormat::VERSION,
+                                 static_cast<uint16_t>(sizeof(VMDecodedInstruction)),
+                                 static_cast<uint32_t>(routines.size()), 0, image.size(), 0};
+        if (!routines.empty()) {
+            std::memcpy(image.data() + sizeof(header), routines.data(), routines.size() * sizeof(VMContainerRoutine));
+        }
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            const Entry& entry = entries_[i];
+            if (!entry.code.empty()) {
+                std::memcpy(image.data() + routines[i].code_offset, entry.code.data(), entry.code.size());
+            }
+            if (!entry.table.empty()) {
+                std::memcpy(image.data() + routines[i].table_offset, entry.table.data(),
+                            entry.table.size() * sizeof(uint32_t));
+            }
+        }
+        header.integrity = VMContainerFormat::integrity(image.data() + sizeof(header), image.size() - sizeof(header));
+        std::memcpy(image.data(), &header, sizeof(header));
+        return image;
+    }
+    size_t size() const { return entries_.size(); }
+private:
+    struct Entry {
+        VMContainerRoutine routine;
+        std::vector<uint8_t> code;
+        std::vector<uint32_t> table;
+    };
+    std::vector<Entry> entries_;
+};
+class VMContainer {
+public:
+    using Key = std::array<uint32_t, 4>;
+    static std::optional<VMContainer> open(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        if (!bytes || size < sizeof(VMContainerHeader) ||
+            reinterpret_cast<uintptr_t>(bytes) % VMContainerFormat::ALIGNMENT != 0) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Container is truncated or misaligned");
+            return std::nullopt;
+        }
+        const VMContainerHeader* header = reinterpret_cast<const VMContainerHeader*>(bytes);
+        if (header->magic != VMContainerFormat::MAGIC || header->version != VMContainerFormat::VERSION ||
+            header->instruction_size != sizeof(VMDecodedInstruction)) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Container format not supported");
+            return std::nullopt;
+        }
+        if (header->total_size != size || size % VMContainerFormat::ALIGNMENT != 0 ||
+            header->routine_count > (size - sizeof(VMContainerHeader)) / sizeof(VMContainerRoutine)) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Container is truncated or misaligned");
+            return std::nullopt;
+        }
+        if (VMContainerFormat::integrity(bytes + sizeof(VMContainerHeader), size - sizeof(VMContainerHeader)) !=
+            header->integrity) {
+            VIVISECT_ERROR(error::ErrorCode::DECRYPTION_FAILED, "VM: Container integrity check failed");
+            return std::nullopt;
+        }
+        VMContainer container;
+        container.data_ = bytes;
+        container.size_ = size;
+        container.routines_ = reinterpret_cast<const VMContainerRoutine*>(bytes + sizeof(VMContainerHeader));
+        container.routine_count_ = header->routine_count;
+        for (size_t i = 0; i < container.routine_count_; ++i) {
+            if (!container.validate(container.routines_[i])) {
+                return std::nullopt;
+            }
+        }
+        return container;
+    }
+    const VMContainerRoutine* find(uint32_t name_hash) const {
+        for (size_t i = 0; i < routine_count_; ++i) {
+            if (routines_[i].name_hash == name_hash) return &routines_[i];
+        }
+        return nullptr;
+    }
+    const VMContainerRoutine* find(std::string_view name) const {
+        return find(VMContainerFormat::hash_name(name));
+    }
+    VMRunStatus execute(VMEngine& engine, const VMContainerRoutine& routine) const {
+        if (routine.kind != VMContainerKind::PLAIN) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Container routine is encrypted");
+            return VMRunStatus::FAULTED;
+        }
+        engine.state_.pc = 0;
+        return engine.execute_threaded<true, false>(code(routine), routine.instruction_count);
+    }
+    template<typename Cipher = XTEACipher>
+    std::optional<VMEncryptedProgram<Cipher>> encrypted(const VMContainerRoutine& routine, const Key& key) const {
+        if (routine.kind != VMContainerKind::ENCRYPTED) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Container routine is not encrypted");
+            return std::nullopt;
+        }
+        return VMEncryptedProgram<Cipher>::view(
+            data_ + routine.code_offset, routine.code_size,
+            reinterpret_cast<const uint32_t*>(data_ + routine.table_offset), routine.table_count,
+            routine.instruction_count, routine.nonce, key);
+    }
+    const VMDecodedInstruction* code(const VMContainerRoutine& routine) const {
+        return reinterpret_cast<const VMDecodedInstruction*>(data_ + routine.code_offset);
+    }
+    const VMContainerRoutine* begin() const { return routines_; }
+    const VMContainerRoutine* end() const { return routines_ + routine_count_; }
+    size_t routine_count() const { return routine_count_; }
+    size_t size() const { return size_; }
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    const VMContainerRoutine* routines_ = nullptr;
+    size_t routine_count_ = 0;
+    VMContainer() = default;
+    bool in_bounds(uint32_t offset, uint64_t length) const {
+        return offset % VMContainerFormat::ALIGNMENT == 0 && offset <= size_ && length <= size_ - offset;
+    }
+    bool validate(const VMContainerRoutine& routine) const {
+        if (routine.instruction_count == 0 || !in_bounds(routine.code_offset, routine.code_size)) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Container routine out of bounds");
+            return false;
+        }
+        if (routine.kind == VMContainerKind::PLAIN) {
+            if (routine.code_size != static_cast<uint64_t>(routine.instruction_count) * sizeof(VMDecodedInstruction)) {
+                VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Container routine out of bounds");
+                return false;
+            }
+            return validate_code(code(routine), routine.instruction_count);
+        }
+        if (routine.kind != VMContainerKind::ENCRYPTED) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Container format not supported");
+            return false;
+        }
+        constexpr size_t window = VMEncryptedProgram<>::WINDOW_INSTRUCTIONS;
+        const uint64_t expected = (static_cast<uint64_t>(routine.instruction_count) + window - 1) / window;
+        if (routine.table_count != expected ||
+            !in_bounds(routine.table_offset, static_cast<uint64_t>(routine.table_count) * sizeof(uint32_t))) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Container routine out of bounds");
+            return false;
+        }
+        const uint32_t* offsets = reinterpret_cast<const uint32_t*>(data_ + routine.table_offset);
+        for (size_t i = 0; i < routine.table_count; ++i) {
+            const uint32_t next = i + 1 < routine.table_count ? offsets[i + 1] : routine.code_size;
+            if (offsets[i] > next) {
+                VIVISECT_ERROR(error::ErrorCode::DECRYPTION_FAILED, "VM: Encrypted bytecode window is corrupt");
+                return false;
+            }
+        }
+        return true;
+    }
+    static bool validate_code(const VMDecodedInstruction* code, size_t length) {
+        for (size_t pc = 0; pc < length; ++pc) {
+            const VMDecodedInstruction& inst = code[pc];
+            if (inst.dest_reg >= 8 || inst.src1_reg >= 8 || inst.src2_reg >= 8) {
+                VIVISECT_ERROR(error::ErrorCode::VM_INVALID_REGISTER, "VM: Invalid register index");
+                return false;
+            }
+            bool branches = false;
+            if (inst.opcode < VMProgram::MAX_OPCODE_SLOTS) {
+                branches = VMBuiltinHandlers::has_branch_target(static_cast<VMOpcode>(inst.opcode));
+            } else if (inst.opcode < VMProgram::MAX_OPCODE_SLOTS + VMEngine::FUSED_OPCODE_COUNT) {
+                for (uint8_t reg : inst.fused_regs) {
+                    if (reg >= 8) {
+                        VIVISECT_ERROR(error::ErrorCode::VM_INVALID_REGISTER, "VM: Invalid register index");
+                        return false;
+                    }
+                }
+                const VMFusedOpcode fused = static_cast<VMFusedOpcode>(inst.opcode);
+                branches = fused == VMFusedOpcode::ALU_JUMP_IF_ZERO || fused == VMFusedOpcode::ALU_JUMP_IF_NOT_ZERO;
+            } else {
+                VIVISECT_ERROR(error::ErrorCode::VM_INVALID_OPCODE, "VM: Invalid or unregistered opcode");
+                return false;
+            }
+            if (branches && inst.immediate > length) {
+                VIVISECT_ERROR(error::ErrorCode::VM_INVALID_JUMP_TARGET, "VM: Branch target outside program");
+                return false;
+            }
+        }
+        return true;
+    }
+};
+class VMMappedFile {
+public:
+    static std::optional<VMMappedFile> open(const char* path) {
+        VMMappedFile file;
+#ifdef _WIN32
+        HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            VIVISECT_ERROR(error::ErrorCode::MODULE_LOAD_FAILED, "VM: Cannot open container file");
+            return std::nullopt;
+        }
+        LARGE_INTEGER length{};
+        if (!GetFileSizeEx(handle, &length) || length.QuadPart == 0) {
+            CloseHandle(handle);
+            VIVISECT_ERROR(error::ErrorCode::MODULE_LOAD_FAILED, "VM: Cannot open container file");
+            return std::nullopt;
+        }
+        HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(handle);
+        if (!mapping) {
+            VIVISECT_ERROR(error::ErrorCode::MODULE_LOAD_FAILED, "VM: Cannot map container file");
+            return std::nullopt;
+        }
+        void* region = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!region) {
+            VIVISECT_ERROR(error::ErrorCode::MODULE_LOAD_FAILED, "VM: Cannot map container file");
+            return std::nullopt;
+        }
+        file.size_ = static_cast<size_t>(length.QuadPart);
+#else
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            VIVISECT_ERROR(error::ErrorCode::MODULE_LOAD_FAILED, "VM: Cannot open container file");
+            return std::nullopt;
+        }
+        struct stat info{};
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            VIVISECT_ERROR(error::ErrorCode::MODULE_LOAD_FAILED, "VM: Cannot open container file");
+            return std::nullopt;
+        }
+        void* region = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (region == MAP_FAILED) {
+            VIVISECT_ERROR(error::ErrorCode::MODULE_LOAD_FAILED, "VM: Cannot map container file");
+            return std::nullopt;
+        }
+        file.size_ = static_cast<size_t>(info.st_size);
+#endif
+        file.region_ = region;
+        return file;
+    }
+    VMMappedFile(VMMappedFile&& other) noexcept : region_(other.region_), size_(other.size_) {
+        other.region_ = nullptr;
+        other.size_ = 0;
+    }
+    VMMappedFile& operator=(VMMappedFile&& other) noexcept {
+        if (this != &other) {
+            release();
+            region_ = other.region_;
+            size_ = other.size_;
+            other.region_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+    VMMappedFile(const VMMappedFile&) = delete;
+    VMMappedFile& operator=(const VMMappedFile&) = delete;
+    ~VMMappedFile() {
+        release();
+    }
+    const void* data() const { return region_; }
+    size_t size() const { return size_; }
+private:
+    void* region_ = nullptr;
+    size_t size_ = 0;
+    VMMappedFile() = default;
+    void release() {
+        if (region_) {
+#ifdef _WIN32
+            UnmapViewOfFile(region_);
+#else
+            munmap(region_, size_);
+#endif
+        }
+        region_ = nullptr;
+        size_ = 0;
+    }
+};
+}
+#endif
@@ -0,0 +1,206 @@
+#ifndef VIVISECT_MODULES_VM_ENCRYPTED_HPP
+#define VIVISECT_MODULES_VM_ENCRYPTED_HPP
+#include <cstdint>
+#include <array>
+#include <optional>
+#include <vector>
+#include "vm_engine.hpp"
+#include "string_crypt.hpp"
+#include "../core/primitives.hpp"
+#include "../error/error.hpp"
+namespace vivisect::modules {
+class VMContainer;
+class VMContainerWriter;
+template<typename Cipher = XTEACipher>
+class VMEncryptedProgram {
+public:
+    using Key = std::array<uint32_t, 4>;
+    static constexpr size_t WINDOW_INSTRUCTIONS = 16;
+    static constexpr size_t MAX_INSTRUCTION_BYTES = 6;
+    static constexpr size_t CACHED_WINDOWS = 4;
+    static std::optional<VMEncryptedProgram> encode(const VMProgram& program, const Key& key) {
+        if (program.empty()) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Invalid bytecode or length");
+            return std::nullopt;
+        }
+        VMEncryptedProgram result;
+        result.key_ = key;
+        result.nonce_ = core::mix_seed(key[0] ^ key[3], static_cast<uint32_t>(program.size()));
+        result.size_ = program.size();
+        result.bytes_.reserve(program.size() * 3);
+        result.block_offsets_.reserve((program.size() + WINDOW_INSTRUCTIONS - 1) / WINDOW_INSTRUCTIONS);
+        for (size_t pc = 0; pc < program.size(); ++pc) {
+            const VMDecodedInstruction& inst = program.data()[pc];
+            if (inst.opcode >= VMProgram::MAX_OPCODE_SLOTS) {
+                VIVISECT_ERROR(error::ErrorCode::VM_INVALID_OPCODE, "VM: Fused instructions cannot be encoded");
+                return std::nullopt;
+            }
+            if (pc % WINDOW_INSTRUCTIONS == 0) {
+                result.block_offsets_.push_back(static_cast<uint32_t>(result.bytes_.size()));
+            }
+            result.encode_instruction(inst);
+        }
+        result.apply_keystream(result.bytes_.data(), 0, result.bytes_.size());
+        return result;
+    }
+    static std::optional<VMEncryptedProgram> encode(const VMProgram& program) {
+        Key key{};
+        key[0] = core::compile_time_seed() ^ static_cast<uint32_t>(program.size());
+        key[1] = core::mix_seed(key[0], static_cast<uint32_t>(core::global_seed));
+        key[2] = core::mix_seed(key[1], static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&program)));
+        key[3] = core::mix_seed(key[2], 0xDEADBEEF);
+        return encode(program, key);
+    }
+    VMRunStatus execute(VMEngine& engine) const {
+        Window windows[CACHED_WINDOWS];
+        for (Window& window : windows) {
+            window.block = NO_BLOCK;
+        }
+        size_t victim = 0;
+        VMRunStatus status = VMRunStatus::COMPLETED;
+        engine.state_.pc = 0;
+        while (engine.state_.pc < size_) {
+            const size_t block = engine.state_.pc / WINDOW_INSTRUCTIONS;
+            Window* window = nullptr;
+            for (Window& cached : windows) {
+                if (cached.block == block) {
+                    window = &cached;
+                    break;
+                }
+            }
+            if (!window) {
+                window = &windows[victim];
+                victim = (victim + 1) % CACHED_WINDOWS;
+                if (!decode_window(block, *window)) {
+                    status = VMRunStatus::FAULTED;
+                    break;
+                }
+            }
+            status = engine.template execute_threaded<true, false, true>(
+                window->code.data(), window->count, 0, block * WINDOW_INSTRUCTIONS);
+            if (status == VMRunStatus::FAULTED) {
+                break;
+            }
+        }
+        core::secure_wipe(windows, sizeof(windows));
+        return status;
+    }
+    size_t size() const { return size_; }
+    size_t encoded_size() const {
+        return byte_count() + block_count() * sizeof(uint32_t);
+    }
+private:
+    friend class VMContainer;
+    friend class VMContainerWriter;
+    static constexpr size_t NO_BLOCK = static_cast<size_t>(-1);
+    struct Window {
+        size_t block;
+        size_t count;
+        std::array<VMDecodedInstruction, WINDOW_INSTRUCTIONS> code;
+    };
+    std::vector<uint8_t> bytes_;
+    std::vector<uint32_t> block_offsets_;
+    Key key_{};
+    uint32_t nonce_ = 0;
+    size_t size_ = 0;
+    const uint8_t* bytes_view_ = nullptr;
+    const uint32_t* block_offsets_view_ = nullptr;
+    size_t bytes_view_size_ = 0;
+    size_t block_view_count_ = 0;
+    VMEncryptedProgram() = default;
+    static VMEncryptedProgram view(const uint8_t* bytes, size_t byte_count, const uint32_t* block_offsets,
+                                   size_t block_count, size_t size, uint32_t nonce, const Key& key) {
+        VMEncryptedProgram result;
+        result.bytes_view_ = bytes;
+        result.bytes_view_size_ = byte_count;
+        result.block_offsets_view_ = block_offsets;
+        result.block_view_count_ = block_count;
+        result.size_ = size;
+        result.nonce_ = nonce;
+        result.key_ = key;
+        return result;
+    }
+    const uint8_t* bytes() const { return bytes_view_ ? bytes_view_ : bytes_.data(); }
+    size_t byte_count() const { return bytes_view_ ? bytes_view_size_ : bytes_.size(); }
+    const uint32_t* block_offsets() const { return block_offsets_view_ ? block_offsets_view_ : block_offsets_.data(); }
+    size_t block_count() const { return block_offsets_view_ ? block_view_count_ : block_offsets_.size(); }
+    static uint8_t immediate_class(uint32_t immediate) {
+        if (immediate == 0) return 0;
+        if (immediate <= 0xFF) return 1;
+        if (immediate <= 0xFFFF) return 2;
+        return 3;
+    }
+    static size_t immediate_bytes(uint8_t imm_class) {
+        return imm_class == 3 ? 4 : imm_class;
+    }
+    void encode_instruction(const VMDecodedInstruction& inst) {
+        const uint8_t imm_class = immediate_class(inst.immediate);
+        bytes_.push_back(static_cast<uint8_t>(inst.opcode | (imm_class << 5) | ((inst.src2_reg >> 2) << 7)));
+        bytes_.push_back(static_cast<uint8_t>(inst.dest_reg | (inst.src1_reg << 3) | ((inst.src2_reg & 3) << 6)));
+        for (size_t i = 0; i < immediate_bytes(imm_class); ++i) {
+            bytes_.push_back(static_cast<uint8_t>(inst.immediate >> (i * 8)));
+        }
+    }
+    void apply_keystream(uint8_t* data, size_t offset, size_t length) const {
+        CounterModeCipher<Cipher>(key_, nonce_).apply(data, offset, length);
+    }
+    bool decode_window(size_t block, Window& window) const {
+        const uint32_t* offsets = block_offsets();
+        const size_t begin = offsets[block];
+        const size_t end = block + 1 < block_count() ? offsets[block + 1] : byte_count();
+        const size_t first = block * WINDOW_INSTRUCTIONS;
+        window.block = block;
+        window.count = (size_ - first < WINDOW_INSTRUCTIONS) ? size_ - first : WINDOW_INSTRUCTIONS;
+        uint8_t plain[WINDOW_INSTRUCTIONS * MAX_INSTRUCTION_BYTES];
+        const size_t length = end - begin;
+        bool ok = begin <= end && length <= sizeof(plain);
+        if (ok) {
+            const uint8_t* encoded = bytes();
+            for (size_t i = 0; i < length; ++i) plain[i] = encoded[begin + i];
+            apply_keystream(plain, begin, length);
+        }
+        size_t cursor = 0;
+        for (size_t n = 0; ok && n < window.count; ++n) {
+            if (cursor + 2 > length) {
+                ok = false;
+                break;
+            }
+            const uint8_t head = plain[cursor];
+            const uint8_t regs = plain[cursor + 1];
+            const size_t imm_size = immediate_bytes(static_cast<uint8_t>((head >> 5) & 3));
+            cursor += 2;
+            if (cursor + imm_size > length) {
+                ok = false;
+                break;
+            }
+            uint32_t immediate = 0;
+            for (size_t i = 0; i < imm_size; ++i) {
+                immediate |= static_cast<uint32_t>(plain[cursor + i]) << (i * 8);
+            }
+            cursor += imm_size;
+            VMDecodedInstruction& inst = window.code[n];
+            inst = VMDecodedInstruction{
+                static_cast<uint16_t>(head & 0x1F),
+                static_cast<uint8_t>(regs & 7),
+                static_cast<uint8_t>((regs >> 3) & 7),
+                static_cast<uint8_t>(((regs >> 6) & 3) | ((head >> 7) << 2)),
+                0, {}, immediate
+            };
+            if (VMBuiltinHandlers::has_branch_target(static_cast<VMOpcode>(inst.opcode)) && immediate > size_) {
+                core::secure_wipe(plain, sizeof(plain));
+                window.block = NO_BLOCK;
+                VIVISECT_ERROR(error::ErrorCode::VM_INVALID_JUMP_TARGET, "VM: Branch target outside program");
+                return false;
+            }
+        }
+        core::secure_wipe(plain, sizeof(plain));
+        if (!ok || cursor != length) {
+            window.block = NO_BLOCK;
+            VIVISECT_ERROR(error::ErrorCode::DECRYPTION_FAILED, "VM: Encrypted bytecode window is corrupt");
+            return false;
+        }
+        return true;
+    }
+};
+}
+#endif
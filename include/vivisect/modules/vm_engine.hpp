@@ -1,11 +1,25 @@
 #ifndef VIVISECT_MODULES_VM_ENGINE_HPP
 #define VIVISECT_MODULES_VM_ENGINE_HPP
 #include <cstdint>
+#include <cstddef>
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <functional>
 #include <cstring>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+    #include <coroutine>
+    #define VIVISECT_VM_COROUTINES
+#endif
 #include "../core/primitives.hpp"
+#include "../core/config.hpp"
 #include "../error/error.hpp"
+#include "vm_host.hpp"
+#include "vm_profile.hpp"
 namespace vivisect::modules {
 enum class VMOpcode : uint8_t {
     ADD,        
@@ -28,7 +42,8 @@ enum class VMOpcode : uint8_t {
     RET,        
     MANGLE_KEY, 
     JUNK_OP,    
-    NOP         
+    NOP,        
+    HOST_CALL   
 };
 struct VMInstruction {
     VMOpcode opcode;
@@ -43,19 +58,66 @@ struct VMInstruction {
                            uint32_t imm = 0)
         : opcode(op), dest_reg(dest), src1_reg(src1), src2_reg(src2), immediate(imm) {}
 };
-struct VMState {
+struct alignas(64) VMState {
     uint32_t registers[8];      
     uint32_t pc;                
     uint32_t flags;             
-    int& global_seed;           
-    uint32_t memory[256];       
-    uint32_t call_stack[32];    
     uint32_t stack_ptr;         
-    VMState(int& seed) : pc(0), flags(0), global_seed(seed), stack_ptr(0) {
+    int global_seed;
+    uint64_t dirty_pages;       
+    int* seed_ref;
+    alignas(64) uint32_t memory[256];
+    uint32_t call_stack[32];    
+    int entry_seed;
+    static constexpr size_t PAGE_WORDS = 8;
+    static constexpr size_t MEMORY_PAGES = 256 / PAGE_WORDS;
+    static constexpr size_t STACK_PAGES = 32 / PAGE_WORDS;
+    static constexpr uint64_t ALL_PAGES = (uint64_t(1) << (MEMORY_PAGES + STACK_PAGES)) - 1;
+    VMState(int& seed) : seed_ref(&seed) {
+        reset();
+    }
+    VMState(const VMState& other, int& seed) : global_seed(seed), seed_ref(&seed), entry_seed(seed) {
+        std::memcpy(registers, other.registers, sizeof(registers));
+        std::memcpy(memory, other.memory, sizeof(memory));
+        std::memcpy(call_stack, other.call_stack, sizeof(call_stack));
+        pc = other.pc;
+        flags = other.flags;
+        stack_ptr = other.stack_ptr;
+        dirty_pages = other.dirty_pages;
+    }
+    void reset() {
+        pc = 0;
+        flags = 0;
+        stack_ptr = 0;
+        dirty_pages = 0;
+        load_seed();
         for (auto& reg : registers) reg = 0;
         for (auto& mem : memory) mem = 0;
         for (auto& stack : call_stack) stack = 0;
     }
+    void load_seed() {
+        global_seed = *seed_ref;
+        entry_seed = global_seed;
+    }
+    void refresh_seed() {
+        const int external = *seed_ref;
+        if (external != entry_seed) {
+            global_seed = external;
+            entry_seed = external;
+        }
+    }
+    void store_seed() {
+        if (global_seed != entry_seed) {
+            *seed_ref = global_seed;
+            entry_seed = global_seed;
+        }
+    }
+    void touch_memory(uint32_t addr) {
+        dirty_pages |= uint64_t(1) << (addr / PAGE_WORDS);
+    }
+    void touch_stack(uint32_t slot) {
+        dirty_pages |= uint64_t(1) << (MEMORY_PAGES + slot / PAGE_WORDS);
+    }
     bool is_valid_register(uint8_t reg) const {
         return reg < 8;
     }
@@ -63,213 +125,1426 @@ struct VMState {
         return addr < 256;
     }
 };
+static_assert(offsetof(VMState, memory) == 64, "VM: Hot state must fit in one cache line");
+struct VMSnapshot {
+    uint32_t registers[8];
+    uint32_t pc;
+    uint32_t flags;
+    uint32_t memory[256];
+    uint32_t call_stack[32];
+    uint32_t stack_ptr;
+};
 using VMHandler = std::function<void(VMState&, const VMInstruction&)>;
-class VMEngine {
+using VMNativeHandler = void(*)(VMState&, const VMInstruction&);
+enum class VMRunStatus {
+    COMPLETED,  
+    SUSPENDED,  
+    FAULTED     
+};
+enum class VMDispatchMode {
+    HANDLER_TABLE,  
+    THREADED        
+};
+enum class VMFusedOpcode : uint16_t {
+    LOAD_IMM_ALU = 32,      
+    ALU_JUMP_IF_ZERO,       
+    ALU_JUMP_IF_NOT_ZERO,   
+    LOAD_ALU_STORE          
+};
+struct VMDecodedInstruction {
+    uint16_t opcode;
+    uint8_t dest_reg;
+    uint8_t src1_reg;
+    uint8_t src2_reg;
+    uint8_t fused_op;
+    uint8_t fused_regs[4];
+    uint32_t immediate;
+    VMInstruction to_instruction() const {
+        return VMInstruction(static_cast<VMOpcode>(opcode), dest_reg, src1_reg, src2_reg, immediate);
+    }
+};
+class VMBuiltinHandlers {
 public:
-    VMEngine(int& seed_ref) : state_(seed_ref), mutation_counter_(0) {
-        initialize_handlers();
+    template<typename Inst>
+    static void add(VMState& s, const Inst& i) {
+        s.registers[i.dest_reg] = s.registers[i.src1_reg] + s.registers[i.src2_reg];
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
     }
-    void execute(const VMInstruction* bytecode, size_t length) {
+    template<typename Inst>
+    static void sub(VMState& s, const Inst& i) {
+        s.registers[i.dest_reg] = s.registers[i.src1_reg] - s.registers[i.src2_reg];
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void mul(VMState& s, const Inst& i) {
+        s.registers[i.dest_reg] = s.registers[i.src1_reg] * s.registers[i.src2_reg];
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void div(VMState& s, const Inst& i) {
+        if (s.registers[i.src2_reg] != 0) {
+            s.registers[i.dest_reg] = s.registers[i.src1_reg] / s.registers[i.src2_reg];
+            s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+        }
+    }
+    template<typename Inst>
+    static void xor_op(VMState& s, const Inst& i) {
+        s.registers[i.dest_reg] = s.registers[i.src1_reg] ^ s.registers[i.src2_reg];
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void and_op(VMState& s, const Inst& i) {
+        s.registers[i.dest_reg] = s.registers[i.src1_reg] & s.registers[i.src2_reg];
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void or_op(VMState& s, const Inst& i) {
+        s.registers[i.dest_reg] = s.registers[i.src1_reg] | s.registers[i.src2_reg];
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void not_op(VMState& s, const Inst& i) {
+        s.registers[i.dest_reg] = ~s.registers[i.src1_reg];
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void shl(VMState& s, const Inst& i) {
+        s.registers[i.dest_reg] = s.registers[i.src1_reg] << s.registers[i.src2_reg];
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void shr(VMState& s, const Inst& i) {
+        s.registers[i.dest_reg] = s.registers[i.src1_reg] >> s.registers[i.src2_reg];
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void load(VMState& s, const Inst& i) {
+        uint32_t addr = s.registers[i.src1_reg];
+        if (s.is_valid_memory(addr)) {
+            s.registers[i.dest_reg] = s.memory[addr];
+        }
+    }
+    template<typename Inst>
+    static void store(VMState& s, const Inst& i) {
+        uint32_t addr = s.registers[i.dest_reg];
+        if (s.is_valid_memory(addr)) {
+            s.memory[addr] = s.registers[i.src1_reg];
+            s.touch_memory(addr);
+        }
+    }
+    template<typename Inst>
+    static void load_imm(VMState& s, const Inst& i) {
+        s.registers[i.dest_reg] = i.immediate;
+    }
+    template<typename Inst>
+    static void jump(VMState& s, const Inst& i) {
+        s.pc = i.immediate;
+    }
+    template<typename Inst>
+    static void jump_if_zero(VMState& s, const Inst& i) {
+        if (s.registers[i.src1_reg] == 0) {
+            s.pc = i.immediate;
+        } else {
+            s.pc++;
+        }
+    }
+    template<typename Inst>
+    static void jump_if_not_zero(VMState& s, const Inst& i) {
+        if (s.registers[i.src1_reg] != 0) {
+            s.pc = i.immediate;
+        } else {
+            s.pc++;
+        }
+    }
+    template<typename Inst>
+    static void call(VMState& s, const Inst& i) {
+        if (s.stack_ptr < 32) {
+            s.touch_stack(s.stack_ptr);
+            s.call_stack[s.stack_ptr++] = s.pc + 1;
+            s.pc = i.immediate;
+        }
+    }
+    template<typename Inst>
+    static void ret(VMState& s, const Inst& i) {
+        if (s.stack_ptr > 0) {
+            s.pc = s.call_stack[--s.stack_ptr];
+        }
+    }
+    template<typename Inst>
+    static void mangle_key(VMState& s, const Inst& i) {
+        uint32_t value = s.registers[i.src1_reg];
+        uint32_t seed = static_cast<uint32_t>(s.global_seed);
+        s.registers[i.dest_reg] = vivisect::core::mix_seed(value, seed);
+    }
+    template<typename Inst>
+    static void junk_op(VMState& s, const Inst& i) {
+        volatile uint32_t temp = s.registers[0];
+        temp = (temp * 0x9e3779b9) ^ 0xDEADBEEF;
+        temp = (temp << 13) | (temp >> 19);
+        (void)temp;
+        vivisect::core::volatile_nop();
+    }
+    template<typename Inst>
+    static void nop(VMState& s, const Inst& i) {
+        vivisect::core::volatile_nop();
+    }
+    template<typename Inst>
+    static void add_mba(VMState& s, const Inst& i) {
+        uint32_t a = s.registers[i.src1_reg], b = s.registers[i.src2_reg];
+        s.registers[i.dest_reg] = (a ^ b) + ((a & b) << 1);
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void add_alias(VMState& s, const Inst& i) {
+        uint32_t a = s.registers[i.src1_reg], b = s.registers[i.src2_reg];
+        s.registers[i.dest_reg] = a - ~b - 1;
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void sub_mba(VMState& s, const Inst& i) {
+        uint32_t a = s.registers[i.src1_reg], b = s.registers[i.src2_reg];
+        s.registers[i.dest_reg] = (a ^ b) - ((~a & b) << 1);
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void sub_alias(VMState& s, const Inst& i) {
+        uint32_t a = s.registers[i.src1_reg], b = s.registers[i.src2_reg];
+        s.registers[i.dest_reg] = a + ~b + 1;
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void xor_mba(VMState& s, const Inst& i) {
+        uint32_t a = s.registers[i.src1_reg], b = s.registers[i.src2_reg];
+        s.registers[i.dest_reg] = (a | b) - (a & b);
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void xor_alias(VMState& s, const Inst& i) {
+        uint32_t a = s.registers[i.src1_reg], b = s.registers[i.src2_reg];
+        s.registers[i.dest_reg] = (a & ~b) | (~a & b);
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void and_mba(VMState& s, const Inst& i) {
+        uint32_t a = s.registers[i.src1_reg], b = s.registers[i.src2_reg];
+        s.registers[i.dest_reg] = (a + b) - (a | b);
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void and_alias(VMState& s, const Inst& i) {
+        uint32_t a = s.registers[i.src1_reg], b = s.registers[i.src2_reg];
+        s.registers[i.dest_reg] = ~(~a | ~b);
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void or_mba(VMState& s, const Inst& i) {
+        uint32_t a = s.registers[i.src1_reg], b = s.registers[i.src2_reg];
+        s.registers[i.dest_reg] = (a ^ b) + (a & b);
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void or_alias(VMState& s, const Inst& i) {
+        uint32_t a = s.registers[i.src1_reg], b = s.registers[i.src2_reg];
+        s.registers[i.dest_reg] = (a & ~b) + b;
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    template<typename Inst>
+    static void not_mba(VMState& s, const Inst& i) {
+        s.registers[i.dest_reg] = 0u - s.registers[i.src1_reg] - 1;
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    static constexpr VMOpcode VARIANT_OPCODES[] = {
+        VMOpcode::ADD, VMOpcode::ADD, VMOpcode::SUB, VMOpcode::SUB, VMOpcode::XOR, VMOpcode::XOR,
+        VMOpcode::AND, VMOpcode::AND, VMOpcode::OR, VMOpcode::OR, VMOpcode::NOT
+    };
+    static constexpr size_t VARIANT_COUNT = sizeof(VARIANT_OPCODES) / sizeof(VARIANT_OPCODES[0]);
+    static constexpr bool is_fusable_alu(VMOpcode op) {
+        return op == VMOpcode::ADD || op == VMOpcode::SUB || op == VMOpcode::MUL ||
+               op == VMOpcode::XOR || op == VMOpcode::AND || op == VMOpcode::OR ||
+               op == VMOpcode::NOT || op == VMOpcode::SHL || op == VMOpcode::SHR;
+    }
+    static uint32_t alu(uint8_t op, uint32_t a, uint32_t b) {
+        switch (static_cast<VMOpcode>(op)) {
+            case VMOpcode::ADD: return a + b;
+            case VMOpcode::SUB: return a - b;
+            case VMOpcode::MUL: return a * b;
+            case VMOpcode::XOR: return a ^ b;
+            case VMOpcode::AND: return a & b;
+            case VMOpcode::OR:  return a | b;
+            case VMOpcode::NOT: return ~a;
+            case VMOpcode::SHL: return a << b;
+            case VMOpcode::SHR: return a >> b;
+            default:            return a;
+        }
+    }
+    static void fused_alu(VMState& s, const VMDecodedInstruction& i) {
+        s.registers[i.dest_reg] = alu(i.fused_op, s.registers[i.src1_reg], s.registers[i.src2_reg]);
+        s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    }
+    static void load_imm_alu(VMState& s, const VMDecodedInstruction& i) {
+        s.registers[i.fused_regs[0]] = i.immediate;
+        fused_alu(s, i);
+        s.pc++;
+    }
+    static void alu_jump_if_zero(VMState& s, const VMDecodedInstruction& i) {
+        fused_alu(s, i);
+        s.pc = (s.registers[i.fused_regs[0]] == 0) ? i.immediate : s.pc + 1;
+    }
+    static void alu_jump_if_not_zero(VMState& s, const VMDecodedInstruction& i) {
+        fused_alu(s, i);
+        s.pc = (s.registers[i.fused_regs[0]] != 0) ? i.immediate : s.pc + 1;
+    }
+    static void load_alu_store(VMState& s, const VMDecodedInstruction& i) {
+        uint32_t load_addr = s.registers[i.fused_regs[1]];
+        if (s.is_valid_memory(load_addr)) {
+            s.registers[i.fused_regs[0]] = s.memory[load_addr];
+        }
+        fused_alu(s, i);
+        uint32_t store_addr = s.registers[i.fused_regs[2]];
+        if (s.is_valid_memory(store_addr)) {
+            s.memory[store_addr] = s.registers[i.fused_regs[3]];
+            s.touch_memory(store_addr);
+        }
+        s.pc++;
+    }
+    template<void (*Handler)(VMState&, const VMInstruction&)>
+    static void checked(VMState& s, const VMInstruction& i) {
+        if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg) && s.is_valid_register(i.src2_reg)) {
+            Handler(s, i);
+        }
+    }
+    static constexpr bool is_control_flow(VMOpcode op) {
+        return op == VMOpcode::JUMP ||
+               op == VMOpcode::JUMP_IF_ZERO ||
+               op == VMOpcode::JUMP_IF_NOT_ZERO ||
+               op == VMOpcode::CALL ||
+               op == VMOpcode::RET;
+    }
+    static constexpr bool has_branch_target(VMOpcode op) {
+        return op == VMOpcode::JUMP ||
+               op == VMOpcode::JUMP_IF_ZERO ||
+               op == VMOpcode::JUMP_IF_NOT_ZERO ||
+               op == VMOpcode::CALL;
+    }
+};
+class VMProgram {
+public:
+    static constexpr size_t MAX_OPCODE_SLOTS = 32;
+    static std::optional<VMProgram> verify(const VMInstruction* bytecode, size_t length) {
         if (!bytecode || length == 0) {
             VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Invalid bytecode or length");
-            return;
+            return std::nullopt;
         }
-        state_.pc = 0;
-        while (state_.pc < length) {
-            const VMInstruction& inst = bytecode[state_.pc];
-            if (!state_.is_valid_register(inst.dest_reg) || 
-                !state_.is_valid_register(inst.src1_reg) || 
-                !state_.is_valid_register(inst.src2_reg)) {
+        VMProgram program;
+        program.code_.reserve(length);
+        for (size_t pc = 0; pc < length; ++pc) {
+            const VMInstruction& inst = bytecode[pc];
+            if (inst.dest_reg >= 8 || inst.src1_reg >= 8 || inst.src2_reg >= 8) {
                 VIVISECT_ERROR(error::ErrorCode::VM_INVALID_REGISTER, "VM: Invalid register index");
-                return;
+                return std::nullopt;
             }
-            size_t handler_index = static_cast<size_t>(inst.opcode);
-            if (handler_index >= handler_table_.size() || !handler_table_[handler_index]) {
+            if (static_cast<size_t>(inst.opcode) >= MAX_OPCODE_SLOTS) {
                 VIVISECT_ERROR(error::ErrorCode::VM_INVALID_OPCODE, "VM: Invalid or unregistered opcode");
-                return;
+                return std::nullopt;
             }
-            try {
-                handler_table_[handler_index](state_, inst);
-            } catch (const std::exception&) {
-                VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Handler execution failed");
-                return;
+            if (VMBuiltinHandlers::has_branch_target(inst.opcode) && inst.immediate > length) {
+                VIVISECT_ERROR(error::ErrorCode::VM_INVALID_JUMP_TARGET, "VM: Branch target outside program");
+                return std::nullopt;
             }
-            if (inst.opcode != VMOpcode::JUMP && 
-                inst.opcode != VMOpcode::JUMP_IF_ZERO &&
-                inst.opcode != VMOpcode::JUMP_IF_NOT_ZERO &&
-                inst.opcode != VMOpcode::CALL &&
-                inst.opcode != VMOpcode::RET) {
-                state_.pc++;
-            }
-            if (++mutation_counter_ % 100 == 0) {
-                mutate_handlers();
+            program.code_.push_back(VMDecodedInstruction{
+                static_cast<uint16_t>(inst.opcode), inst.dest_reg, inst.src1_reg, inst.src2_reg, 0, {}, inst.immediate
+            });
+        }
+        return program;
+    }
+    template<size_t N>
+    static std::optional<VMProgram> verify(const std::array<VMInstruction, N>& bytecode) {
+        return verify(bytecode.data(), N);
+    }
+    const VMDecodedInstruction* data() const { return code_.data(); }
+    size_t size() const { return code_.size(); }
+    bool empty() const { return code_.empty(); }
+private:
+    friend class VMPeepholeOptimizer;
+    friend class VMDeadCodeEliminator;
+    template<size_t N>
+    friend class VMStaticProgram;
+    VMProgram() = default;
+    std::vector<VMDecodedInstruction> code_;
+};
+struct VMAssembler;
+template<size_t N>
+class VMStaticProgram {
+public:
+    constexpr const VMDecodedInstruction* data() const { return code_.data(); }
+    constexpr size_t size() const { return N; }
+    VMProgram to_program() const {
+        VMProgram program;
+        program.code_.assign(code_.begin(), code_.end());
+        return program;
+    }
+private:
+    friend struct VMAssembler;
+    constexpr VMStaticProgram() : code_{} {}
+    std::array<VMDecodedInstruction, N> code_;
+};
+#ifdef VIVISECT_VM_COROUTINES
+template<typename Scheduler>
+struct VMStepAwaitable;
+#endif
+template<typename Cipher>
+class VMEncryptedProgram;
+class VMContainer;
+template<const auto& Program>
+class VMCompiledProgram;
+class VMEngine {
+public:
+    static constexpr size_t HANDLER_TABLE_SIZE = 32;
+    static constexpr size_t MAX_HANDLER_SLOTS = 256;
+    static constexpr size_t BUILTIN_HANDLER_COUNT = static_cast<size_t>(VMOpcode::HOST_CALL) + 1;
+    static constexpr uint8_t HOST_CALL_HANDLER = static_cast<uint8_t>(VMOpcode::HOST_CALL);
+    static constexpr uint8_t CUSTOM_HANDLER = BUILTIN_HANDLER_COUNT;
+    static constexpr uint8_t EMPTY_HANDLER = BUILTIN_HANDLER_COUNT + 1;
+    static constexpr uint8_t FIRST_FUSED_HANDLER = EMPTY_HANDLER + 1;
+    static constexpr size_t FUSED_OPCODE_COUNT = 4;
+    static constexpr uint8_t FIRST_VARIANT_HANDLER = FIRST_FUSED_HANDLER + FUSED_OPCODE_COUNT;
+    static constexpr size_t HOST_FUNCTION_SLOTS = 32;
+    static constexpr size_t TRACE_SLOTS = 16;
+    static constexpr size_t MAX_TRACE_LENGTH = 256;
+    static constexpr uint32_t TRACE_THRESHOLD = 16;
+    static_assert(static_cast<size_t>(VMFusedOpcode::LOAD_IMM_ALU) == HANDLER_TABLE_SIZE);
+    struct HandlerTable {
+        std::array<VMHandler, HANDLER_TABLE_SIZE> handlers;
+        std::array<uint8_t, HANDLER_TABLE_SIZE> kinds;
+    };
+    VMEngine(int& seed_ref, VMDispatchMode mode = VMDispatchMode::HANDLER_TABLE)
+        : state_(seed_ref), table_(builtin_table()), mutation_counter_(0), dispatch_mode_(mode) {
+        apply_profile();
+        for (size_t i = 0; i < FUSED_OPCODE_COUNT; ++i) {
+            handler_slots_[HANDLER_TABLE_SIZE + i] = static_cast<uint16_t>(MAX_HANDLER_SLOTS + i);
+            handler_kinds_[MAX_HANDLER_SLOTS + i] = static_cast<uint8_t>(FIRST_FUSED_HANDLER + i);
+        }
+        reset_dispatch();
+    }
+    void reset() {
+        state_.reset();
+        apply_profile();
+        reset_dispatch();
+        clear_traces();
+        active_program_ = nullptr;
+        snapshot_base_ = nullptr;
+    }
+    std::shared_ptr<const VMSnapshot> snapshot() {
+        auto snapshot = std::make_shared<VMSnapshot>();
+        std::memcpy(snapshot->registers, state_.registers, sizeof(state_.registers));
+        std::memcpy(snapshot->memory, state_.memory, sizeof(state_.memory));
+        std::memcpy(snapshot->call_stack, state_.call_stack, sizeof(state_.call_stack));
+        snapshot->pc = state_.pc;
+        snapshot->flags = state_.flags;
+        snapshot->stack_ptr = state_.stack_ptr;
+        state_.dirty_pages = 0;
+        snapshot_base_ = snapshot;
+        return snapshot;
+    }
+    void restore(const std::shared_ptr<const VMSnapshot>& snapshot) {
+        if (!snapshot) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Invalid snapshot");
+            return;
+        }
+        std::memcpy(state_.registers, snapshot->registers, sizeof(state_.registers));
+        state_.pc = snapshot->pc;
+        state_.flags = snapshot->flags;
+        state_.stack_ptr = snapshot->stack_ptr;
+        uint64_t pages = snapshot_base_ == snapshot ? state_.dirty_pages : VMState::ALL_PAGES;
+        while (pages) {
+            const size_t page = static_cast<size_t>(std::countr_zero(pages));
+            pages &= pages - 1;
+            if (page < VMState::MEMORY_PAGES) {
+                const size_t word = page * VMState::PAGE_WORDS;
+                std::memcpy(&state_.memory[word], &snapshot->memory[word], VMState::PAGE_WORDS * sizeof(uint32_t));
+            } else {
+                const size_t word = (page - VMState::MEMORY_PAGES) * VMState::PAGE_WORDS;
+                std::memcpy(&state_.call_stack[word], &snapshot->call_stack[word], VMState::PAGE_WORDS * sizeof(uint32_t));
             }
         }
+        state_.dirty_pages = 0;
+        snapshot_base_ = snapshot;
+        active_program_ = nullptr;
+    }
+    VMEngine fork() const {
+        return VMEngine(*this, *state_.seed_ref);
+    }
+    VMEngine fork(int& seed_ref) const {
+        return VMEngine(*this, seed_ref);
+    }
+    void set_register(uint8_t reg, uint32_t value) {
+        if (reg < 8) state_.registers[reg] = value;
+    }
+    uint32_t get_register(uint8_t reg) const {
+        return reg < 8 ? state_.registers[reg] : 0;
+    }
+    void execute(const VMInstruction* bytecode, size_t length) {
+        if (!bytecode || length == 0) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Invalid bytecode or length");
+            return;
+        }
+        state_.pc = 0;
+        if (dispatch_mode_ == VMDispatchMode::THREADED) {
+            execute_threaded<false, false>(bytecode, length);
+            return;
+        }
+        state_.load_seed();
+        execute_table(bytecode, length);
+        state_.store_seed();
     }
     template<size_t N>
     void execute(const std::array<VMInstruction, N>& bytecode) {
         execute(bytecode.data(), N);
     }
+    VMRunStatus execute(const VMProgram& program) {
+        if (program.empty()) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Invalid bytecode or length");
+            return VMRunStatus::FAULTED;
+        }
+        state_.pc = 0;
+        return execute_threaded<true, false>(program.data(), program.size());
+    }
+    template<size_t N>
+    VMRunStatus execute(const VMStaticProgram<N>& program) {
+        state_.pc = 0;
+        return execute_threaded<true, false>(program.data(), N);
+    }
+    void start(const VMProgram& program) {
+        active_program_ = &program;
+        state_.pc = 0;
+        clear_traces();
+    }
+    void start(VMProgram&&) = delete;
+    VMRunStatus step(size_t budget) {
+        if (!active_program_ || active_program_->empty()) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: No program started");
+            return VMRunStatus::FAULTED;
+        }
+        VMRunStatus status = execute_threaded<true, true>(active_program_->data(), active_program_->size(), budget);
+        if (status != VMRunStatus::SUSPENDED) {
+            active_program_ = nullptr;
+        }
+        return status;
+    }
+    bool is_running() const { return active_program_ != nullptr; }
+#ifdef VIVISECT_VM_COROUTINES
+    template<typename Scheduler>
+    auto step_async(size_t budget, Scheduler& scheduler) {
+        return VMStepAwaitable<Scheduler>{*this, budget, scheduler};
+    }
+#endif
     void register_handler(VMOpcode op, VMHandler handler) {
         size_t index = static_cast<size_t>(op);
-        if (index < handler_table_.size()) {
-            handler_table_[index] = handler;
+        if (index < HANDLER_TABLE_SIZE) {
+            if (table_.use_count() != 1) {
+                table_ = std::make_shared<HandlerTable>(*table_);
+            }
+            uint8_t kind = handler ? CUSTOM_HANDLER : EMPTY_HANDLER;
+            table_->handlers[index] = std::move(handler);
+            table_->kinds[index] = kind;
+            clear_traces();
+            for (size_t slot = 0; slot < handler_count_; ++slot) {
+                if (slot_opcodes_[slot] == index) handler_kinds_[slot] = kind;
+            }
+        }
+    }
+    template<auto Fn>
+    void register_host_function(uint8_t id) {
+        if (id < HOST_FUNCTION_SLOTS) {
+            host_functions_[id] = VMHostSignature<Fn>::descriptor();
+        }
+    }
+    void unregister_host_function(uint8_t id) {
+        if (id < HOST_FUNCTION_SLOTS) {
+            host_functions_[id] = VMHostFunction{};
         }
     }
     void mutate_handlers() {
-        uint32_t seed = static_cast<uint32_t>(state_.global_seed);
+        schedule_mutation();
+        if (mutation_frequency_ == 0) return;
+        uint32_t seed = mutation_seed_;
         for (size_t i = 0; i < 5; i++) {
             seed = seed * 1103515245 + 12345;
-            size_t idx1 = (seed >> 16) % handler_table_.size();
+            size_t slot1 = (seed >> 16) % handler_count_;
             seed = seed * 1103515245 + 12345;
-            size_t idx2 = (seed >> 16) % handler_table_.size();
-            if (handler_table_[idx1] && handler_table_[idx2]) {
-                std::swap(handler_table_[idx1], handler_table_[idx2]);
-            }
+            size_t slot2 = (seed >> 16) % handler_count_;
+            const size_t op1 = slot_opcodes_[slot1];
+            const size_t op2 = slot_opcodes_[slot2];
+            const bool active1 = handler_slots_[op1] == slot1;
+            const bool active2 = handler_slots_[op2] == slot2;
+            std::swap(handler_kinds_[slot1], handler_kinds_[slot2]);
+            std::swap(slot_opcodes_[slot1], slot_opcodes_[slot2]);
+            if (active1) handler_slots_[op1] = static_cast<uint16_t>(slot2);
+            if (active2) handler_slots_[op2] = static_cast<uint16_t>(slot1);
+            handler_slots_[slot_opcodes_[slot1]] = static_cast<uint16_t>(slot1);
+        }
+        mutation_seed_ = seed;
+#ifdef VIVISECT_VM_PROFILING
+        profiler_.record_mutation();
+#endif
+    }
+    void set_dispatch_mode(VMDispatchMode mode) { dispatch_mode_ = mode; }
+    VMDispatchMode get_dispatch_mode() const { return dispatch_mode_; }
+    uint32_t get_dispatch_count() const { return mutation_counter_; }
+    void set_mutation_frequency(uint32_t frequency) {
+        mutation_frequency_ = frequency;
+        mutation_frequency_pinned_ = true;
+        schedule_mutation();
+    }
+    uint32_t get_mutation_frequency() const { return mutation_frequency_; }
+    void set_trace_threshold(uint32_t threshold) {
+        trace_threshold_ = threshold;
+        clear_traces();
+    }
+    uint32_t get_trace_threshold() const { return trace_threshold_; }
+    size_t get_trace_count() const {
+        size_t count = 0;
+        for (const TraceSlot& slot : trace_slots_) {
+            if (!slot.ops.empty()) ++count;
         }
-        vivisect::core::volatile_seed_update(state_.global_seed);
+        return count;
     }
+    uint16_t get_handler_slot(VMOpcode op) const { return handler_slots_[static_cast<size_t>(op)]; }
+    size_t get_handler_count() const { return handler_count_; }
     const VMState& get_state() const { return state_; }
-    VMState& get_state() { return state_; }
+    VMState& get_state() {
+        state_.dirty_pages = VMState::ALL_PAGES;
+        return state_;
+    }
+    bool shares_builtin_handlers() const { return table_ == builtin_table(); }
+#ifdef VIVISECT_VM_PROFILING
+    static constexpr bool PROFILING_ENABLED = true;
+    const VMProfileSnapshot& get_profile() const { return profiler_.snapshot(); }
+    void clear_profile() { profiler_.clear(); }
+#else
+    static constexpr bool PROFILING_ENABLED = false;
+    VMProfileSnapshot get_profile() const { return {}; }
+    void clear_profile() {}
+#endif
 private:
+    template<typename Cipher>
+    friend class VMEncryptedProgram;
+    friend class VMContainer;
+    template<const auto& Program>
+    friend class VMCompiledProgram;
+    static constexpr uint32_t NO_TRACE = static_cast<uint32_t>(-1);
+    enum TraceKind : uint8_t {
+        TRACE_ADD, TRACE_SUB, TRACE_MUL, TRACE_DIV, TRACE_XOR, TRACE_AND, TRACE_OR,
+        TRACE_NOT, TRACE_SHL, TRACE_SHR, TRACE_LOAD, TRACE_STORE, TRACE_LOAD_IMM,
+        TRACE_MANGLE_KEY, TRACE_JUNK_OP, TRACE_NOP, TRACE_GUARD_ZERO, TRACE_GUARD_NOT_ZERO, TRACE_END
+    };
+    struct TraceOp {
+        TraceKind kind;
+        uint8_t dest_reg;
+        uint8_t src1_reg;
+        uint8_t src2_reg;
+        uint32_t immediate;
+        uint32_t exit_pc;
+        uint32_t dispatched;
+    };
+    struct TraceSlot {
+        uint32_t header = NO_TRACE;
+        uint32_t hits = 0;
+        uint32_t dispatches = 0;
+        bool failed = false;
+        std::vector<TraceOp> ops;
+    };
     VMState state_;
-    std::array<VMHandler, 32> handler_table_;
+    std::shared_ptr<HandlerTable> table_;
+    std::array<uint16_t, HANDLER_TABLE_SIZE + FUSED_OPCODE_COUNT> handler_slots_;
+    std::array<uint8_t, MAX_HANDLER_SLOTS + FUSED_OPCODE_COUNT> handler_kinds_;
+    std::array<uint8_t, MAX_HANDLER_SLOTS> slot_opcodes_;
+    size_t handler_count_ = HANDLER_TABLE_SIZE;
+    std::array<VMHostFunction, HOST_FUNCTION_SLOTS> host_functions_{};
     uint32_t mutation_counter_;
-    void initialize_handlers() {
-        register_handler(VMOpcode::ADD, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg) && s.is_valid_register(i.src2_reg)) {
-                s.registers[i.dest_reg] = s.registers[i.src1_reg] + s.registers[i.src2_reg];
-                s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+    uint32_t mutation_frequency_ = 0;
+    bool mutation_frequency_pinned_ = false;
+    uint32_t next_mutation_ = 0;
+    uint32_t mutation_seed_ = 0;
+    VMDispatchMode dispatch_mode_;
+    const VMProgram* active_program_ = nullptr;
+#ifdef VIVISECT_VM_PROFILING
+    VMProfiler profiler_;
+#endif
+    std::shared_ptr<const VMSnapshot> snapshot_base_;
+    uint32_t trace_threshold_ = TRACE_THRESHOLD;
+    std::array<TraceSlot, TRACE_SLOTS> trace_slots_;
+    VMEngine(const VMEngine& other, int& seed_ref)
+        : state_(other.state_, seed_ref), table_(other.table_), handler_slots_(other.handler_slots_),
+          handler_kinds_(other.handler_kinds_), slot_opcodes_(other.slot_opcodes_),
+          handler_count_(other.handler_count_), host_functions_(other.host_functions_),
+          mutation_counter_(other.mutation_counter_), mutation_frequency_(other.mutation_frequency_),
+          mutation_frequency_pinned_(other.mutation_frequency_pinned_), next_mutation_(other.next_mutation_), mutation_seed_(other.mutation_seed_),
+          dispatch_mode_(other.dispatch_mode_), active_program_(nullptr),
+#ifdef VIVISECT_VM_PROFILING
+          profiler_(other.profiler_),
+#endif
+          snapshot_base_(other.snapshot_base_), trace_threshold_(other.trace_threshold_) {}
+    uint64_t profile_begin() const {
+#ifdef VIVISECT_VM_PROFILING
+        return VMProfiler::read_cycles();
+#else
+        return 0;
+#endif
+    }
+    template<typename Inst>
+    void profile_end(const Inst& inst, uint64_t started) {
+#ifdef VIVISECT_VM_PROFILING
+        const size_t opcode = static_cast<size_t>(inst.opcode);
+        profiler_.record(opcode, VMProfiler::read_cycles() - started);
+        if (opcode == static_cast<size_t>(VMOpcode::JUMP_IF_ZERO) ||
+            opcode == static_cast<size_t>(VMOpcode::JUMP_IF_NOT_ZERO)) {
+            const bool zero = state_.registers[inst.src1_reg] == 0;
+            profiler_.record_branch(opcode, zero == (opcode == static_cast<size_t>(VMOpcode::JUMP_IF_ZERO)));
+        }
+        if constexpr (std::is_same_v<Inst, VMDecodedInstruction>) {
+            if (opcode == static_cast<size_t>(VMFusedOpcode::ALU_JUMP_IF_ZERO) ||
+                opcode == static_cast<size_t>(VMFusedOpcode::ALU_JUMP_IF_NOT_ZERO)) {
+                const bool zero = state_.registers[inst.fused_regs[0]] == 0;
+                profiler_.record_branch(opcode, zero == (opcode == static_cast<size_t>(VMFusedOpcode::ALU_JUMP_IF_ZERO)));
             }
-        });
-        register_handler(VMOpcode::SUB, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg) && s.is_valid_register(i.src2_reg)) {
-                s.registers[i.dest_reg] = s.registers[i.src1_reg] - s.registers[i.src2_reg];
-                s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+        }
+#else
+        (void)inst;
+        (void)started;
+#endif
+    }
+    static const std::shared_ptr<HandlerTable>& builtin_table() {
+        static const std::shared_ptr<HandlerTable> table = [] {
+            auto built = std::make_shared<HandlerTable>();
+            built->kinds.fill(EMPTY_HANDLER);
+            initialize_handlers(*built);
+            return built;
+        }();
+        return table;
+    }
+    struct SlotLayout {
+        std::array<uint8_t, MAX_HANDLER_SLOTS> kinds;
+        std::array<uint8_t, MAX_HANDLER_SLOTS> opcodes;
+    };
+    static const SlotLayout& slot_layout() {
+        static const SlotLayout layout = [] {
+            SlotLayout built{};
+            const HandlerTable& table = *builtin_table();
+            for (size_t slot = 0; slot < MAX_HANDLER_SLOTS; ++slot) {
+                if (slot < HANDLER_TABLE_SIZE) {
+                    built.opcodes[slot] = static_cast<uint8_t>(slot);
+                    built.kinds[slot] = table.kinds[slot];
+                    continue;
+                }
+                const size_t op = (slot - HANDLER_TABLE_SIZE) % BUILTIN_HANDLER_COUNT;
+                const size_t round = (slot - HANDLER_TABLE_SIZE) / BUILTIN_HANDLER_COUNT;
+                uint8_t variants[1 + VMBuiltinHandlers::VARIANT_COUNT];
+                size_t count = 0;
+                variants[count++] = static_cast<uint8_t>(op);
+                for (size_t v = 0; v < VMBuiltinHandlers::VARIANT_COUNT; ++v) {
+                    if (static_cast<size_t>(VMBuiltinHandlers::VARIANT_OPCODES[v]) == op) {
+                        variants[count++] = static_cast<uint8_t>(FIRST_VARIANT_HANDLER + v);
+                    }
+                }
+                built.opcodes[slot] = static_cast<uint8_t>(op);
+                built.kinds[slot] = variants[(round + 1) % count];
             }
-        });
-        register_handler(VMOpcode::MUL, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg) && s.is_valid_register(i.src2_reg)) {
-                s.registers[i.dest_reg] = s.registers[i.src1_reg] * s.registers[i.src2_reg];
-                s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+            return built;
+        }();
+        return layout;
+    }
+    void apply_profile() {
+        const config::ObfuscationProfile& profile = config::ConfigurationManager::instance().get_profile();
+        if (!mutation_frequency_pinned_) {
+            mutation_frequency_ = profile.mutate_vm_handlers && profile.vm_mutation_frequency > 0
+                ? static_cast<uint32_t>(profile.vm_mutation_frequency) : 0;
+        }
+        handler_count_ = profile.vm_handler_count > static_cast<int>(HANDLER_TABLE_SIZE)
+            ? std::min(static_cast<size_t>(profile.vm_handler_count), MAX_HANDLER_SLOTS) : HANDLER_TABLE_SIZE;
+    }
+    void reset_dispatch() {
+        const SlotLayout& layout = slot_layout();
+        std::memcpy(handler_kinds_.data(), layout.kinds.data(), handler_count_);
+        std::memcpy(slot_opcodes_.data(), layout.opcodes.data(), handler_count_);
+        for (size_t i = 0; i < HANDLER_TABLE_SIZE; ++i) {
+            handler_slots_[i] = static_cast<uint16_t>(i);
+        }
+        if (!shares_builtin_handlers()) {
+            for (size_t slot = 0; slot < handler_count_; ++slot) {
+                const size_t op = slot_opcodes_[slot];
+                if (table_->kinds[op] != op) handler_kinds_[slot] = table_->kinds[op];
             }
-        });
-        register_handler(VMOpcode::DIV, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg) && s.is_valid_register(i.src2_reg)) {
-                if (s.registers[i.src2_reg] != 0) {
-                    s.registers[i.dest_reg] = s.registers[i.src1_reg] / s.registers[i.src2_reg];
-                    s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
-                }
+        }
+        mutation_counter_ = 0;
+        mutation_seed_ = static_cast<uint32_t>(state_.global_seed);
+        schedule_mutation();
+    }
+    void schedule_mutation() {
+        next_mutation_ = mutation_frequency_ ? mutation_counter_ + mutation_frequency_ : mutation_counter_;
+    }
+    static void install_builtin(HandlerTable& table, VMOpcode op, VMNativeHandler handler) {
+        size_t index = static_cast<size_t>(op);
+        table.handlers[index] = handler;
+        table.kinds[index] = static_cast<uint8_t>(index);
+    }
+    template<typename Inst>
+    bool valid_registers(const Inst& inst) const {
+        return state_.is_valid_register(inst.dest_reg) &&
+               state_.is_valid_register(inst.src1_reg) &&
+               state_.is_valid_register(inst.src2_reg);
+    }
+    bool invoke_custom_handler(size_t index, const VMInstruction& inst) {
+        state_.dirty_pages = VMState::ALL_PAGES;
+        try {
+            table_->handlers[index](state_, inst);
+        } catch (const std::exception&) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Handler execution failed");
+            return false;
+        }
+        return true;
+    }
+    bool invoke_custom_handler(size_t index, const VMDecodedInstruction& inst) {
+        return invoke_custom_handler(index, inst.to_instruction());
+    }
+    template<typename Inst>
+    bool invoke_host_call(const Inst& inst) {
+        const VMHostFunction* function = inst.immediate < HOST_FUNCTION_SLOTS ? &host_functions_[inst.immediate] : nullptr;
+        if (!function || !function->thunk) {
+            VIVISECT_ERROR(error::ErrorCode::VM_INVALID_OPCODE, "VM: Unregistered host function");
+            return false;
+        }
+        if (static_cast<size_t>(inst.src1_reg) + function->arity > 8) {
+            VIVISECT_ERROR(error::ErrorCode::VM_INVALID_REGISTER, "VM: Host call arguments exceed register file");
+            return false;
+        }
+        state_.store_seed();
+        try {
+            const uint32_t result = function->thunk(&state_.registers[inst.src1_reg]);
+            if (function->returns_value) {
+                state_.registers[inst.dest_reg] = result;
             }
-        });
-        register_handler(VMOpcode::XOR, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg) && s.is_valid_register(i.src2_reg)) {
-                s.registers[i.dest_reg] = s.registers[i.src1_reg] ^ s.registers[i.src2_reg];
-                s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+        } catch (const std::exception&) {
+            state_.refresh_seed();
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Host call failed");
+            return false;
+        }
+        state_.refresh_seed();
+        return true;
+    }
+    void clear_traces() {
+        for (TraceSlot& slot : trace_slots_) {
+            slot.header = NO_TRACE;
+            slot.hits = 0;
+            slot.failed = false;
+            slot.ops.clear();
+        }
+    }
+    void advance_dispatch(uint32_t count) {
+        while (count != 0) {
+            const uint32_t remaining = next_mutation_ - mutation_counter_;
+            if (remaining == 0 || remaining > count) {
+                mutation_counter_ += count;
+                return;
             }
-        });
-        register_handler(VMOpcode::AND, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg) && s.is_valid_register(i.src2_reg)) {
-                s.registers[i.dest_reg] = s.registers[i.src1_reg] & s.registers[i.src2_reg];
-                s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+            mutation_counter_ += remaining;
+            count -= remaining;
+            mutate_handlers();
+        }
+    }
+    static std::optional<TraceKind> trace_kind(uint16_t opcode) {
+        switch (static_cast<VMOpcode>(opcode)) {
+            case VMOpcode::MANGLE_KEY: return TRACE_MANGLE_KEY;
+            case VMOpcode::JUNK_OP:    return TRACE_JUNK_OP;
+            case VMOpcode::NOP:        return TRACE_NOP;
+            default:
+                if (opcode <= static_cast<uint16_t>(VMOpcode::LOAD_IMM)) return static_cast<TraceKind>(opcode);
+                return std::nullopt;
+        }
+    }
+    bool traceable(const VMDecodedInstruction& inst) const {
+        const uint16_t opcode = inst.opcode;
+        if (opcode >= HANDLER_TABLE_SIZE) return VMBuiltinHandlers::is_fusable_alu(static_cast<VMOpcode>(inst.fused_op));
+        if (table_->kinds[opcode] != opcode) return false;
+        return opcode <= static_cast<uint16_t>(VMOpcode::JUMP_IF_NOT_ZERO) || trace_kind(opcode).has_value();
+    }
+    void compile_trace_op(TraceSlot& slot, const VMDecodedInstruction& inst, uint32_t pc, uint32_t dispatched) {
+        const uint16_t opcode = inst.opcode;
+        const TraceKind alu = static_cast<TraceKind>(inst.fused_op);
+        switch (opcode) {
+            case static_cast<uint16_t>(VMOpcode::JUMP):
+                return;
+            case static_cast<uint16_t>(VMOpcode::JUMP_IF_ZERO):
+            case static_cast<uint16_t>(VMOpcode::JUMP_IF_NOT_ZERO): {
+                const bool zero = state_.registers[inst.src1_reg] == 0;
+                const bool taken = state_.pc == inst.immediate;
+                slot.ops.push_back(TraceOp{zero ? TRACE_GUARD_ZERO : TRACE_GUARD_NOT_ZERO, 0, inst.src1_reg, 0, 0,
+                                           taken ? pc + 1 : inst.immediate, dispatched});
+                return;
             }
-        });
-        register_handler(VMOpcode::OR, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg) && s.is_valid_register(i.src2_reg)) {
-                s.registers[i.dest_reg] = s.registers[i.src1_reg] | s.registers[i.src2_reg];
-                s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+            case static_cast<uint16_t>(VMFusedOpcode::LOAD_IMM_ALU):
+                slot.ops.push_back(TraceOp{TRACE_LOAD_IMM, inst.fused_regs[0], 0, 0, inst.immediate, 0, 0});
+                slot.ops.push_back(TraceOp{alu, inst.dest_reg, inst.src1_reg, inst.src2_reg, 0, 0, 0});
+                return;
+            case static_cast<uint16_t>(VMFusedOpcode::ALU_JUMP_IF_ZERO):
+            case static_cast<uint16_t>(VMFusedOpcode::ALU_JUMP_IF_NOT_ZERO): {
+                const bool zero = state_.registers[inst.fused_regs[0]] == 0;
+                const bool taken = state_.pc == inst.immediate;
+                slot.ops.push_back(TraceOp{alu, inst.dest_reg, inst.src1_reg, inst.src2_reg, 0, 0, 0});
+                slot.ops.push_back(TraceOp{zero ? TRACE_GUARD_ZERO : TRACE_GUARD_NOT_ZERO, 0, inst.fused_regs[0], 0, 0,
+                                           taken ? pc + 1 : inst.immediate, dispatched});
+                return;
             }
-        });
-        register_handler(VMOpcode::NOT, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg)) {
-                s.registers[i.dest_reg] = ~s.registers[i.src1_reg];
-                s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+            case static_cast<uint16_t>(VMFusedOpcode::LOAD_ALU_STORE):
+                slot.ops.push_back(TraceOp{TRACE_LOAD, inst.fused_regs[0], inst.fused_regs[1], 0, 0, 0, 0});
+                slot.ops.push_back(TraceOp{alu, inst.dest_reg, inst.src1_reg, inst.src2_reg, 0, 0, 0});
+                slot.ops.push_back(TraceOp{TRACE_STORE, inst.fused_regs[2], inst.fused_regs[3], 0, 0, 0, 0});
+                return;
+            default:
+                slot.ops.push_back(TraceOp{*trace_kind(opcode), inst.dest_reg, inst.src1_reg, inst.src2_reg, inst.immediate, 0, 0});
+                return;
+        }
+    }
+    void step_builtin(const VMDecodedInstruction& inst) {
+        switch (inst.opcode) {
+            case static_cast<uint16_t>(VMOpcode::ADD): VMBuiltinHandlers::add(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::SUB): VMBuiltinHandlers::sub(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::MUL): VMBuiltinHandlers::mul(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::DIV): VMBuiltinHandlers::div(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::XOR): VMBuiltinHandlers::xor_op(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::AND): VMBuiltinHandlers::and_op(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::OR): VMBuiltinHandlers::or_op(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::NOT): VMBuiltinHandlers::not_op(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::SHL): VMBuiltinHandlers::shl(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::SHR): VMBuiltinHandlers::shr(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::LOAD): VMBuiltinHandlers::load(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::STORE): VMBuiltinHandlers::store(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::LOAD_IMM): VMBuiltinHandlers::load_imm(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::JUMP): VMBuiltinHandlers::jump(state_, inst); return;
+            case static_cast<uint16_t>(VMOpcode::JUMP_IF_ZERO): VMBuiltinHandlers::jump_if_zero(state_, inst); return;
+            case static_cast<uint16_t>(VMOpcode::JUMP_IF_NOT_ZERO): VMBuiltinHandlers::jump_if_not_zero(state_, inst); return;
+            case static_cast<uint16_t>(VMOpcode::MANGLE_KEY): VMBuiltinHandlers::mangle_key(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::JUNK_OP): VMBuiltinHandlers::junk_op(state_, inst); break;
+            case static_cast<uint16_t>(VMOpcode::NOP): VMBuiltinHandlers::nop(state_, inst); break;
+            case static_cast<uint16_t>(VMFusedOpcode::LOAD_IMM_ALU): VMBuiltinHandlers::load_imm_alu(state_, inst); return;
+            case static_cast<uint16_t>(VMFusedOpcode::ALU_JUMP_IF_ZERO): VMBuiltinHandlers::alu_jump_if_zero(state_, inst); return;
+            case static_cast<uint16_t>(VMFusedOpcode::ALU_JUMP_IF_NOT_ZERO): VMBuiltinHandlers::alu_jump_if_not_zero(state_, inst); return;
+            case static_cast<uint16_t>(VMFusedOpcode::LOAD_ALU_STORE): VMBuiltinHandlers::load_alu_store(state_, inst); return;
+        }
+        state_.pc++;
+    }
+    template<bool Budgeted>
+    bool record_trace(TraceSlot& slot, const VMDecodedInstruction* bytecode, size_t length, size_t& budget) {
+        const uint32_t header = state_.pc;
+        uint32_t dispatched = 0;
+        slot.ops.clear();
+        while (dispatched < MAX_TRACE_LENGTH && state_.pc < length) {
+            if constexpr (Budgeted) {
+                if (budget == 0) {
+                    slot.ops.clear();
+                    return false;
+                }
+            }
+            const VMDecodedInstruction& inst = bytecode[state_.pc];
+            if (!traceable(inst)) break;
+            if constexpr (Budgeted) --budget;
+            const uint32_t pc = state_.pc;
+            step_builtin(inst);
+            compile_trace_op(slot, inst, pc, ++dispatched);
+            if (++mutation_counter_ == next_mutation_) mutate_handlers();
+            if (state_.pc == header) {
+                slot.ops.push_back(TraceOp{TRACE_END, 0, 0, 0, 0, header, dispatched});
+                slot.dispatches = dispatched;
+                return true;
+            }
+        }
+        slot.ops.clear();
+        slot.failed = true;
+        return false;
+    }
+    template<TraceKind Kind>
+    void trace_step(uint32_t* regs, uint32_t& flags, const TraceOp& op) {
+        const uint32_t a = regs[op.src1_reg];
+        const uint32_t b = regs[op.src2_reg];
+        if constexpr (Kind == TRACE_LOAD) {
+            if (state_.is_valid_memory(a)) regs[op.dest_reg] = state_.memory[a];
+        } else if constexpr (Kind == TRACE_STORE) {
+            const uint32_t addr = regs[op.dest_reg];
+            if (state_.is_valid_memory(addr)) {
+                state_.memory[addr] = a;
+                state_.touch_memory(addr);
             }
-        });
-        register_handler(VMOpcode::SHL, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg) && s.is_valid_register(i.src2_reg)) {
-                s.registers[i.dest_reg] = s.registers[i.src1_reg] << s.registers[i.src2_reg];
-                s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+        } else if constexpr (Kind == TRACE_LOAD_IMM) {
+            regs[op.dest_reg] = op.immediate;
+        } else if constexpr (Kind == TRACE_MANGLE_KEY) {
+            regs[op.dest_reg] = vivisect::core::mix_seed(a, static_cast<uint32_t>(state_.global_seed));
+        } else if constexpr (Kind == TRACE_JUNK_OP) {
+            volatile uint32_t temp = regs[0];
+            temp = (temp * 0x9e3779b9) ^ 0xDEADBEEF;
+            temp = (temp << 13) | (temp >> 19);
+            (void)temp;
+            vivisect::core::volatile_nop();
+        } else if constexpr (Kind == TRACE_NOP) {
+            vivisect::core::volatile_nop();
+        } else if constexpr (Kind == TRACE_DIV) {
+            if (b != 0) {
+                regs[op.dest_reg] = a / b;
+                flags = regs[op.dest_reg] == 0 ? 1 : 0;
             }
-        });
-        register_handler(VMOpcode::SHR, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg) && s.is_valid_register(i.src2_reg)) {
-                s.registers[i.dest_reg] = s.registers[i.src1_reg] >> s.registers[i.src2_reg];
-                s.flags = (s.registers[i.dest_reg] == 0) ? 1 : 0;
+        } else {
+            regs[op.dest_reg] = VMBuiltinHandlers::alu(static_cast<uint8_t>(Kind), a, b);
+            flags = regs[op.dest_reg] == 0 ? 1 : 0;
+        }
+    }
+    template<bool Budgeted>
+    void execute_trace(const TraceSlot& slot, size_t& budget) {
+        uint32_t regs[8];
+        std::memcpy(regs, state_.registers, sizeof(regs));
+        uint32_t flags = state_.flags;
+        const TraceOp* op = slot.ops.data();
+        if constexpr (Budgeted) {
+            if (budget < slot.dispatches) {
+                state_.pc = slot.header;
+                return;
             }
-        });
-        register_handler(VMOpcode::LOAD, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg)) {
-                uint32_t addr = s.registers[i.src1_reg];
-                if (s.is_valid_memory(addr)) {
-                    s.registers[i.dest_reg] = s.memory[addr];
+            budget -= slot.dispatches;
+        }
+#if defined(__GNUC__) || defined(__clang__)
+        static void* const labels[] = {
+            &&trace_add, &&trace_sub, &&trace_mul, &&trace_div, &&trace_xor, &&trace_and, &&trace_or,
+            &&trace_not, &&trace_shl, &&trace_shr, &&trace_load, &&trace_store, &&trace_load_imm,
+            &&trace_mangle_key, &&trace_junk_op, &&trace_nop, &&trace_guard_zero, &&trace_guard_not_zero, &&trace_end
+        };
+        static_assert(sizeof(labels) / sizeof(labels[0]) == TRACE_END + 1);
+#define VIVISECT_VM_TRACE_OP(label, step) \
+        label: \
+            trace_step<step>(regs, flags, *op); \
+            goto *labels[(++op)->kind];
+        goto *labels[op->kind];
+        VIVISECT_VM_TRACE_OP(trace_add, TRACE_ADD)
+        VIVISECT_VM_TRACE_OP(trace_sub, TRACE_SUB)
+        VIVISECT_VM_TRACE_OP(trace_mul, TRACE_MUL)
+        VIVISECT_VM_TRACE_OP(trace_div, TRACE_DIV)
+        VIVISECT_VM_TRACE_OP(trace_xor, TRACE_XOR)
+        VIVISECT_VM_TRACE_OP(trace_and, TRACE_AND)
+        VIVISECT_VM_TRACE_OP(trace_or, TRACE_OR)
+        VIVISECT_VM_TRACE_OP(trace_not, TRACE_NOT)
+        VIVISECT_VM_TRACE_OP(trace_shl, TRACE_SHL)
+        VIVISECT_VM_TRACE_OP(trace_shr, TRACE_SHR)
+        VIVISECT_VM_TRACE_OP(trace_load, TRACE_LOAD)
+        VIVISECT_VM_TRACE_OP(trace_store, TRACE_STORE)
+        VIVISECT_VM_TRACE_OP(trace_load_imm, TRACE_LOAD_IMM)
+        VIVISECT_VM_TRACE_OP(trace_mangle_key, TRACE_MANGLE_KEY)
+        VIVISECT_VM_TRACE_OP(trace_junk_op, TRACE_JUNK_OP)
+        VIVISECT_VM_TRACE_OP(trace_nop, TRACE_NOP)
+#undef VIVISECT_VM_TRACE_OP
+        trace_guard_zero:
+            if (regs[op->src1_reg] != 0) goto trace_exit;
+            goto *labels[(++op)->kind];
+        trace_guard_not_zero:
+            if (regs[op->src1_reg] == 0) goto trace_exit;
+            goto *labels[(++op)->kind];
+        trace_end:
+            advance_dispatch(slot.dispatches);
+            op = slot.ops.data();
+            if constexpr (Budgeted) {
+                if (budget < slot.dispatches) {
+                    std::memcpy(state_.registers, regs, sizeof(regs));
+                    state_.flags = flags;
+                    state_.pc = slot.header;
+                    return;
                 }
+                budget -= slot.dispatches;
+            }
+            goto *labels[op->kind];
+#else
+        while (true) {
+            switch (op->kind) {
+                case TRACE_ADD: trace_step<TRACE_ADD>(regs, flags, *op); break;
+                case TRACE_SUB: trace_step<TRACE_SUB>(regs, flags, *op); break;
+                case TRACE_MUL: trace_step<TRACE_MUL>(regs, flags, *op); break;
+                case TRACE_DIV: trace_step<TRACE_DIV>(regs, flags, *op); break;
+                case TRACE_XOR: trace_step<TRACE_XOR>(regs, flags, *op); break;
+                case TRACE_AND: trace_step<TRACE_AND>(regs, flags, *op); break;
+                case TRACE_OR: trace_step<TRACE_OR>(regs, flags, *op); break;
+                case TRACE_NOT: trace_step<TRACE_NOT>(regs, flags, *op); break;
+                case TRACE_SHL: trace_step<TRACE_SHL>(regs, flags, *op); break;
+                case TRACE_SHR: trace_step<TRACE_SHR>(regs, flags, *op); break;
+                case TRACE_LOAD: trace_step<TRACE_LOAD>(regs, flags, *op); break;
+                case TRACE_STORE: trace_step<TRACE_STORE>(regs, flags, *op); break;
+                case TRACE_LOAD_IMM: trace_step<TRACE_LOAD_IMM>(regs, flags, *op); break;
+                case TRACE_MANGLE_KEY: trace_step<TRACE_MANGLE_KEY>(regs, flags, *op); break;
+                case TRACE_JUNK_OP: trace_step<TRACE_JUNK_OP>(regs, flags, *op); break;
+                case TRACE_NOP: trace_step<TRACE_NOP>(regs, flags, *op); break;
+                case TRACE_GUARD_ZERO:
+                    if (regs[op->src1_reg] != 0) goto trace_exit;
+                    break;
+                case TRACE_GUARD_NOT_ZERO:
+                    if (regs[op->src1_reg] == 0) goto trace_exit;
+                    break;
+                case TRACE_END:
+                    advance_dispatch(slot.dispatches);
+                    op = slot.ops.data();
+                    if constexpr (Budgeted) {
+                        if (budget < slot.dispatches) {
+                            std::memcpy(state_.registers, regs, sizeof(regs));
+                            state_.flags = flags;
+                            state_.pc = slot.header;
+                            return;
+                        }
+                        budget -= slot.dispatches;
+                    }
+                    continue;
+            }
+            ++op;
+        }
+#endif
+    trace_exit:
+        std::memcpy(state_.registers, regs, sizeof(regs));
+        state_.flags = flags;
+        state_.pc = op->exit_pc;
+        if constexpr (Budgeted) budget += slot.dispatches - op->dispatched;
+        advance_dispatch(op->dispatched);
+    }
+    template<bool Budgeted>
+    void run_trace(const VMDecodedInstruction* bytecode, size_t length, size_t& budget) {
+        const uint32_t header = state_.pc;
+        TraceSlot& slot = trace_slots_[header % TRACE_SLOTS];
+        if (slot.header != header) {
+            slot.header = header;
+            slot.hits = 0;
+            slot.failed = false;
+            slot.ops.clear();
+        }
+        if (slot.ops.empty()) {
+            if (slot.failed || ++slot.hits < trace_threshold_) return;
+            if (!record_trace<Budgeted>(slot, bytecode, length, budget)) return;
+        }
+        execute_trace<Budgeted>(slot, budget);
+    }
+#if !defined(__GNUC__) && !defined(__clang__)
+    void execute_fused(uint8_t kind, const VMDecodedInstruction& inst) {
+        switch (kind - FIRST_FUSED_HANDLER) {
+            case 0: VMBuiltinHandlers::load_imm_alu(state_, inst); break;
+            case 1: VMBuiltinHandlers::alu_jump_if_zero(state_, inst); break;
+            case 2: VMBuiltinHandlers::alu_jump_if_not_zero(state_, inst); break;
+            case 3: VMBuiltinHandlers::load_alu_store(state_, inst); break;
+        }
+    }
+#endif
+    void execute_table(const VMInstruction* bytecode, size_t length) {
+        while (state_.pc < length) {
+            const VMInstruction& inst = bytecode[state_.pc];
+            if (!state_.is_valid_register(inst.dest_reg) || 
+                !state_.is_valid_register(inst.src1_reg) || 
+                !state_.is_valid_register(inst.src2_reg)) {
+                VIVISECT_ERROR(error::ErrorCode::VM_INVALID_REGISTER, "VM: Invalid register index");
+                return;
+            }
+            size_t handler_index = static_cast<size_t>(inst.opcode);
+            if (handler_index >= HANDLER_TABLE_SIZE || handler_kinds_[handler_slots_[handler_index]] == EMPTY_HANDLER) {
+                VIVISECT_ERROR(error::ErrorCode::VM_INVALID_OPCODE, "VM: Invalid or unregistered opcode");
+                return;
             }
-        });
-        register_handler(VMOpcode::STORE, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg)) {
-                uint32_t addr = s.registers[i.dest_reg];
-                if (s.is_valid_memory(addr)) {
-                    s.memory[addr] = s.registers[i.src1_reg];
+            const uint8_t kind = handler_kinds_[handler_slots_[handler_index]];
+            const uint64_t started = profile_begin();
+            if (kind == HOST_CALL_HANDLER) {
+                if (!invoke_host_call(inst)) return;
+            } else if (kind == CUSTOM_HANDLER) {
+                if (!invoke_custom_handler(handler_index, inst)) return;
+            } else {
+                try {
+                    table_->handlers[handler_index](state_, inst);
+                } catch (const std::exception&) {
+                    VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Handler execution failed");
+                    return;
                 }
             }
-        });
-        register_handler(VMOpcode::LOAD_IMM, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg)) {
-                s.registers[i.dest_reg] = i.immediate;
+            profile_end(inst, started);
+            if (!VMBuiltinHandlers::is_control_flow(inst.opcode)) {
+                state_.pc++;
             }
-        });
-        register_handler(VMOpcode::JUMP, [](VMState& s, const VMInstruction& i) {
-            s.pc = i.immediate;
-        });
-        register_handler(VMOpcode::JUMP_IF_ZERO, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.src1_reg)) {
-                if (s.registers[i.src1_reg] == 0) {
-                    s.pc = i.immediate;
-                } else {
-                    s.pc++;
+            if (++mutation_counter_ == next_mutation_) {
+                mutate_handlers();
+            }
+        }
+    }
+    template<bool Verified, bool Budgeted, bool Windowed = false, typename Inst>
+    VMRunStatus execute_threaded(const Inst* bytecode, size_t length, size_t budget = 0, size_t origin = 0) {
+        state_.load_seed();
+        const VMRunStatus status = dispatch_threaded<Verified, Budgeted, Windowed>(bytecode, length, budget, origin);
+        state_.store_seed();
+        return status;
+    }
+    template<bool Verified, bool Budgeted, bool Windowed, typename Inst>
+    VMRunStatus dispatch_threaded(const Inst* bytecode, size_t length, size_t budget, size_t origin) {
+        constexpr bool Traced = Verified && !Windowed && !PROFILING_ENABLED && std::is_same_v<Inst, VMDecodedInstruction>;
+        const size_t base = Windowed ? origin : 0;
+        const Inst* inst = nullptr;
+        if constexpr (Traced && !Budgeted) clear_traces();
+        size_t handler_index = 0;
+        [[maybe_unused]] uint64_t started = 0;
+#if defined(__GNUC__) || defined(__clang__)
+        static void* const labels[] = {
+            &&op_add, &&op_sub, &&op_mul, &&op_div, &&op_xor, &&op_and, &&op_or,
+            &&op_not, &&op_shl, &&op_shr, &&op_load, &&op_store, &&op_load_imm,
+            &&op_jump, &&op_jump_if_zero, &&op_jump_if_not_zero, &&op_call, &&op_ret,
+            &&op_mangle_key, &&op_junk_op, &&op_nop, &&op_host_call, &&op_custom, &&op_empty,
+            &&op_load_imm_alu, &&op_alu_jump_if_zero, &&op_alu_jump_if_not_zero, &&op_load_alu_store,
+            &&op_add_mba, &&op_add_alias, &&op_sub_mba, &&op_sub_alias, &&op_xor_mba, &&op_xor_alias,
+            &&op_and_mba, &&op_and_alias, &&op_or_mba, &&op_or_alias, &&op_not_mba
+        };
+        static_assert(sizeof(labels) / sizeof(labels[0]) == FIRST_VARIANT_HANDLER + VMBuiltinHandlers::VARIANT_COUNT);
+#define VIVISECT_VM_DISPATCH() \
+        do { \
+            if (static_cast<size_t>(state_.pc) - base >= length) return VMRunStatus::COMPLETED; \
+            if constexpr (Budgeted) { \
+                if (budget == 0) return VMRunStatus::SUSPENDED; \
+                --budget; \
+            } \
+            inst = &bytecode[state_.pc - base]; \
+            handler_index = static_cast<size_t>(inst->opcode); \
+            if constexpr (!Verified) { \
+                if (!valid_registers(*inst)) { \
+                    VIVISECT_ERROR(error::ErrorCode::VM_INVALID_REGISTER, "VM: Invalid register index"); \
+                    return VMRunStatus::FAULTED; \
+                } \
+                if (handler_index >= HANDLER_TABLE_SIZE) goto op_empty; \
+            } \
+            goto *labels[handler_kinds_[handler_slots_[handler_index]]]; \
+        } while (0)
+#define VIVISECT_VM_CONTINUE() \
+        do { \
+            if (++mutation_counter_ == next_mutation_) mutate_handlers(); \
+            VIVISECT_VM_DISPATCH(); \
+        } while (0)
+#define VIVISECT_VM_NEXT() \
+        do { \
+            if (!VMBuiltinHandlers::is_control_flow(static_cast<VMOpcode>(inst->opcode))) state_.pc++; \
+            VIVISECT_VM_CONTINUE(); \
+        } while (0)
+#define VIVISECT_VM_OP(label, fn) \
+        label: \
+            started = profile_begin(); \
+            VMBuiltinHandlers::fn(state_, *inst); \
+            profile_end(*inst, started); \
+            VIVISECT_VM_NEXT();
+#define VIVISECT_VM_BACK_EDGE() \
+        do { \
+            if constexpr (Traced) { \
+                if (state_.pc <= static_cast<size_t>(inst - bytecode) && trace_threshold_ != 0) { \
+                    if (++mutation_counter_ == next_mutation_) mutate_handlers(); \
+                    run_trace<Budgeted>(bytecode, length, budget); \
+                    VIVISECT_VM_DISPATCH(); \
+                } \
+            } \
+        } while (0)
+#define VIVISECT_VM_BRANCH_OP(label, fn) \
+        label: \
+            started = profile_begin(); \
+            VMBuiltinHandlers::fn(state_, *inst); \
+            profile_end(*inst, started); \
+            VIVISECT_VM_BACK_EDGE(); \
+            VIVISECT_VM_NEXT();
+        VIVISECT_VM_DISPATCH();
+        VIVISECT_VM_OP(op_add, add)
+        VIVISECT_VM_OP(op_sub, sub)
+        VIVISECT_VM_OP(op_mul, mul)
+        VIVISECT_VM_OP(op_div, div)
+        VIVISECT_VM_OP(op_xor, xor_op)
+        VIVISECT_VM_OP(op_and, and_op)
+        VIVISECT_VM_OP(op_or, or_op)
+        VIVISECT_VM_OP(op_not, not_op)
+        VIVISECT_VM_OP(op_shl, shl)
+        VIVISECT_VM_OP(op_shr, shr)
+        VIVISECT_VM_OP(op_load, load)
+        VIVISECT_VM_OP(op_store, store)
+        VIVISECT_VM_OP(op_load_imm, load_imm)
+        VIVISECT_VM_BRANCH_OP(op_jump, jump)
+        VIVISECT_VM_BRANCH_OP(op_jump_if_zero, jump_if_zero)
+        VIVISECT_VM_BRANCH_OP(op_jump_if_not_zero, jump_if_not_zero)
+        VIVISECT_VM_OP(op_call, call)
+        VIVISECT_VM_OP(op_ret, ret)
+        VIVISECT_VM_OP(op_mangle_key, mangle_key)
+        VIVISECT_VM_OP(op_junk_op, junk_op)
+        VIVISECT_VM_OP(op_nop, nop)
+        op_host_call:
+            started = profile_begin();
+            if (!invoke_host_call(*inst)) return VMRunStatus::FAULTED;
+            profile_end(*inst, started);
+            VIVISECT_VM_NEXT();
+        op_custom:
+            started = profile_begin();
+            if (!invoke_custom_handler(handler_index, *inst)) return VMRunStatus::FAULTED;
+            profile_end(*inst, started);
+            VIVISECT_VM_NEXT();
+        op_empty:
+            VIVISECT_ERROR(error::ErrorCode::VM_INVALID_OPCODE, "VM: Invalid or unregistered opcode");
+            return VMRunStatus::FAULTED;
+#define VIVISECT_VM_FUSED_OP(label, fn) \
+        label: \
+            if constexpr (Verified) { \
+                started = profile_begin(); \
+                VMBuiltinHandlers::fn(state_, *inst); \
+                profile_end(*inst, started); \
+            } \
+            VIVISECT_VM_CONTINUE();
+#define VIVISECT_VM_FUSED_BRANCH_OP(label, fn) \
+        label: \
+            if constexpr (Verified) { \
+                started = profile_begin(); \
+                VMBuiltinHandlers::fn(state_, *inst); \
+                profile_end(*inst, started); \
+                VIVISECT_VM_BACK_EDGE(); \
+            } \
+            VIVISECT_VM_CONTINUE();
+        VIVISECT_VM_FUSED_OP(op_load_imm_alu, load_imm_alu)
+        VIVISECT_VM_FUSED_BRANCH_OP(op_alu_jump_if_zero, alu_jump_if_zero)
+        VIVISECT_VM_FUSED_BRANCH_OP(op_alu_jump_if_not_zero, alu_jump_if_not_zero)
+        VIVISECT_VM_FUSED_OP(op_load_alu_store, load_alu_store)
+        VIVISECT_VM_OP(op_add_mba, add_mba)
+        VIVISECT_VM_OP(op_add_alias, add_alias)
+        VIVISECT_VM_OP(op_sub_mba, sub_mba)
+        VIVISECT_VM_OP(op_sub_alias, sub_alias)
+        VIVISECT_VM_OP(op_xor_mba, xor_mba)
+        VIVISECT_VM_OP(op_xor_alias, xor_alias)
+        VIVISECT_VM_OP(op_and_mba, and_mba)
+        VIVISECT_VM_OP(op_and_alias, and_alias)
+        VIVISECT_VM_OP(op_or_mba, or_mba)
+        VIVISECT_VM_OP(op_or_alias, or_alias)
+        VIVISECT_VM_OP(op_not_mba, not_mba)
+#undef VIVISECT_VM_FUSED_BRANCH_OP
+#undef VIVISECT_VM_FUSED_OP
+#undef VIVISECT_VM_BRANCH_OP
+#undef VIVISECT_VM_BACK_EDGE
+#undef VIVISECT_VM_OP
+#undef VIVISECT_VM_CONTINUE
+#undef VIVISECT_VM_NEXT
+#undef VIVISECT_VM_DISPATCH
+#else
+        using BuiltinHandler = void(*)(VMState&, const Inst&);
+        static constexpr BuiltinHandler builtins[] = {
+            &VMBuiltinHandlers::add<Inst>, &VMBuiltinHandlers::sub<Inst>, &VMBuiltinHandlers::mul<Inst>,
+            &VMBuiltinHandlers::div<Inst>, &VMBuiltinHandlers::xor_op<Inst>, &VMBuiltinHandlers::and_op<Inst>,
+            &VMBuiltinHandlers::or_op<Inst>, &VMBuiltinHandlers::not_op<Inst>, &VMBuiltinHandlers::shl<Inst>,
+            &VMBuiltinHandlers::shr<Inst>, &VMBuiltinHandlers::load<Inst>, &VMBuiltinHandlers::store<Inst>,
+            &VMBuiltinHandlers::load_imm<Inst>, &VMBuiltinHandlers::jump<Inst>, &VMBuiltinHandlers::jump_if_zero<Inst>,
+            &VMBuiltinHandlers::jump_if_not_zero<Inst>, &VMBuiltinHandlers::call<Inst>, &VMBuiltinHandlers::ret<Inst>,
+            &VMBuiltinHandlers::mangle_key<Inst>, &VMBuiltinHandlers::junk_op<Inst>, &VMBuiltinHandlers::nop<Inst>
+        };
+        static_assert(sizeof(builtins) / sizeof(builtins[0]) == static_cast<size_t>(VMOpcode::HOST_CALL));
+        static constexpr BuiltinHandler variants[] = {
+            &VMBuiltinHandlers::add_mba<Inst>, &VMBuiltinHandlers::add_alias<Inst>, &VMBuiltinHandlers::sub_mba<Inst>,
+            &VMBuiltinHandlers::sub_alias<Inst>, &VMBuiltinHandlers::xor_mba<Inst>, &VMBuiltinHandlers::xor_alias<Inst>,
+            &VMBuiltinHandlers::and_mba<Inst>, &VMBuiltinHandlers::and_alias<Inst>, &VMBuiltinHandlers::or_mba<Inst>,
+            &VMBuiltinHandlers::or_alias<Inst>, &VMBuiltinHandlers::not_mba<Inst>
+        };
+        static_assert(sizeof(variants) / sizeof(variants[0]) == VMBuiltinHandlers::VARIANT_COUNT);
+        while (static_cast<size_t>(state_.pc) - base < length) {
+            if constexpr (Budgeted) {
+                if (budget == 0) return VMRunStatus::SUSPENDED;
+                --budget;
+            }
+            inst = &bytecode[state_.pc - base];
+            handler_index = static_cast<size_t>(inst->opcode);
+            if constexpr (!Verified) {
+                if (!valid_registers(*inst)) {
+                    VIVISECT_ERROR(error::ErrorCode::VM_INVALID_REGISTER, "VM: Invalid register index");
+                    return VMRunStatus::FAULTED;
                 }
             }
-        });
-        register_handler(VMOpcode::JUMP_IF_NOT_ZERO, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.src1_reg)) {
-                if (s.registers[i.src1_reg] != 0) {
-                    s.pc = i.immediate;
-                } else {
-                    s.pc++;
+            uint8_t kind = (Verified || handler_index < HANDLER_TABLE_SIZE)
+                ? handler_kinds_[handler_slots_[handler_index]] : EMPTY_HANDLER;
+            started = profile_begin();
+            if (kind == HOST_CALL_HANDLER) {
+                if (!invoke_host_call(*inst)) return VMRunStatus::FAULTED;
+            } else if (kind < BUILTIN_HANDLER_COUNT) {
+                builtins[kind](state_, *inst);
+            } else if (kind >= FIRST_VARIANT_HANDLER) {
+                variants[kind - FIRST_VARIANT_HANDLER](state_, *inst);
+            } else if (kind >= FIRST_FUSED_HANDLER) {
+                if constexpr (Verified) {
+                    execute_fused(kind, *inst);
+                    profile_end(*inst, started);
+                }
+                if (++mutation_counter_ == next_mutation_) {
+                    mutate_handlers();
+                }
+                if constexpr (Traced) {
+                    if (kind != FIRST_FUSED_HANDLER && kind != FIRST_FUSED_HANDLER + 3 &&
+                        state_.pc <= static_cast<size_t>(inst - bytecode) && trace_threshold_ != 0) {
+                        run_trace<Budgeted>(bytecode, length, budget);
+                    }
                 }
+                continue;
+            } else if (kind == CUSTOM_HANDLER) {
+                if (!invoke_custom_handler(handler_index, *inst)) return VMRunStatus::FAULTED;
+            } else {
+                VIVISECT_ERROR(error::ErrorCode::VM_INVALID_OPCODE, "VM: Invalid or unregistered opcode");
+                return VMRunStatus::FAULTED;
             }
-        });
-        register_handler(VMOpcode::CALL, [](VMState& s, const VMInstruction& i) {
-            if (s.stack_ptr < 32) {
-                s.call_stack[s.stack_ptr++] = s.pc + 1;
-                s.pc = i.immediate;
+            profile_end(*inst, started);
+            if (!VMBuiltinHandlers::is_control_flow(static_cast<VMOpcode>(inst->opcode))) {
+                state_.pc++;
             }
-        });
-        register_handler(VMOpcode::RET, [](VMState& s, const VMInstruction& i) {
-            if (s.stack_ptr > 0) {
-                s.pc = s.call_stack[--s.stack_ptr];
+            if (++mutation_counter_ == next_mutation_) {
+                mutate_handlers();
             }
-        });
-        register_handler(VMOpcode::MANGLE_KEY, [](VMState& s, const VMInstruction& i) {
-            if (s.is_valid_register(i.dest_reg) && s.is_valid_register(i.src1_reg)) {
-                uint32_t value = s.registers[i.src1_reg];
-                uint32_t seed = static_cast<uint32_t>(s.global_seed);
-                s.registers[i.dest_reg] = vivisect::core::mix_seed(value, seed);
+            if constexpr (Traced) {
+                if (VMBuiltinHandlers::has_branch_target(static_cast<VMOpcode>(inst->opcode)) &&
+                    inst->opcode != static_cast<uint16_t>(VMOpcode::CALL) &&
+                    state_.pc <= static_cast<size_t>(inst - bytecode) && trace_threshold_ != 0) {
+                    run_trace<Budgeted>(bytecode, length, budget);
+                }
             }
-        });
-        register_handler(VMOpcode::JUNK_OP, [](VMState& s, const VMInstruction& i) {
-            volatile uint32_t temp = s.registers[0];
-            temp = (temp * 0x9e3779b9) ^ 0xDEADBEEF;
-            temp = (temp << 13) | (temp >> 19);
-            (void)temp;
-            vivisect::core::volatile_nop();
-        });
-        register_handler(VMOpcode::NOP, [](VMState& s, const VMInstruction& i) {
-            vivisect::core::volatile_nop();
-        });
+        }
+        return VMRunStatus::COMPLETED;
+#endif
+    }
+    static void initialize_handlers(HandlerTable& table) {
+        install_builtin(table, VMOpcode::ADD, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::add<VMInstruction>>);
+        install_builtin(table, VMOpcode::SUB, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::sub<VMInstruction>>);
+        install_builtin(table, VMOpcode::MUL, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::mul<VMInstruction>>);
+        install_builtin(table, VMOpcode::DIV, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::div<VMInstruction>>);
+        install_builtin(table, VMOpcode::XOR, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::xor_op<VMInstruction>>);
+        install_builtin(table, VMOpcode::AND, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::and_op<VMInstruction>>);
+        install_builtin(table, VMOpcode::OR, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::or_op<VMInstruction>>);
+        install_builtin(table, VMOpcode::NOT, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::not_op<VMInstruction>>);
+        install_builtin(table, VMOpcode::SHL, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::shl<VMInstruction>>);
+        install_builtin(table, VMOpcode::SHR, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::shr<VMInstruction>>);
+        install_builtin(table, VMOpcode::LOAD, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::load<VMInstruction>>);
+        install_builtin(table, VMOpcode::STORE, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::store<VMInstruction>>);
+        install_builtin(table, VMOpcode::LOAD_IMM, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::load_imm<VMInstruction>>);
+        install_builtin(table, VMOpcode::JUMP, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::jump<VMInstruction>>);
+        install_builtin(table, VMOpcode::JUMP_IF_ZERO, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::jump_if_zero<VMInstruction>>);
+        install_builtin(table, VMOpcode::JUMP_IF_NOT_ZERO, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::jump_if_not_zero<VMInstruction>>);
+        install_builtin(table, VMOpcode::CALL, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::call<VMInstruction>>);
+        install_builtin(table, VMOpcode::RET, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::ret<VMInstruction>>);
+        install_builtin(table, VMOpcode::MANGLE_KEY, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::mangle_key<VMInstruction>>);
+        install_builtin(table, VMOpcode::JUNK_OP, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::junk_op<VMInstruction>>);
+        install_builtin(table, VMOpcode::NOP, &VMBuiltinHandlers::checked<&VMBuiltinHandlers::nop<VMInstruction>>);
+        table.kinds[static_cast<size_t>(VMOpcode::HOST_CALL)] = HOST_CALL_HANDLER;
+    }
+};
+#ifdef VIVISECT_VM_COROUTINES
+template<typename Scheduler>
+struct VMStepAwaitable {
+    VMEngine& engine;
+    size_t budget;
+    Scheduler& scheduler;
+    VMRunStatus status = VMRunStatus::SUSPENDED;
+    bool await_ready() {
+        status = engine.step(budget);
+        return status != VMRunStatus::SUSPENDED;
+    }
+    void await_suspend(std::coroutine_handle<> handle) {
+        scheduler(handle);
+    }
+    VMRunStatus await_resume() const {
+        return status;
     }
 };
+#endif
 template<size_t N>
 struct VMBytecode {
     std::array<VMInstruction, N> instructions;
@@ -0,0 +1,187 @@
+#ifndef VIVISECT_MODULES_VM_EXECUTOR_HPP
+#define VIVISECT_MODULES_VM_EXECUTOR_HPP
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "vm_engine.hpp"
+#include "../core/primitives.hpp"
+#include "../error/error.hpp"
+namespace vivisect::modules {
+struct VMJobResult {
+    VMRunStatus status = VMRunStatus::FAULTED;
+    std::array<uint32_t, 8> registers{};
+};
+class VMExecutor {
+public:
+    using Registers = std::array<uint32_t, 8>;
+    using Callback = std::function<void(const VMJobResult&)>;
+    using EngineSetup = std::function<void(VMEngine&)>;
+    explicit VMExecutor(size_t worker_count = 0,
+                        uint32_t base_seed = static_cast<uint32_t>(vivisect::core::global_seed),
+                        EngineSetup setup = {})
+        : base_seed_(base_seed), setup_(std::move(setup)) {
+        if (worker_count == 0) {
+            worker_count = std::thread::hardware_concurrency();
+            if (worker_count == 0) worker_count = 1;
+        }
+        workers_.reserve(worker_count);
+        for (size_t i = 0; i < worker_count; ++i) {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+        for (size_t i = 0; i < worker_count; ++i) {
+            workers_[i]->thread = std::thread([this, i] { run(i); });
+        }
+    }
+    VMExecutor(const VMExecutor&) = delete;
+    VMExecutor& operator=(const VMExecutor&) = delete;
+    ~VMExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            if (worker->thread.joinable()) worker->thread.join();
+        }
+    }
+    using ProgramPtr = std::shared_ptr<const VMProgram>;
+    std::future<VMJobResult> submit(const VMProgram&, const Registers& = {}) = delete;
+    std::future<VMJobResult> submit(VMProgram&& program, const Registers& registers = {}) {
+        return submit(std::make_shared<const VMProgram>(std::move(program)), registers);
+    }
+    std::future<VMJobResult> submit(ProgramPtr program, const Registers& registers = {}) {
+        Job job = make_job(std::move(program), registers);
+        job.promise.emplace();
+        std::future<VMJobResult> result = job.promise->get_future();
+        enqueue(std::move(job));
+        return result;
+    }
+    void submit(const VMProgram&, const Registers&, Callback) = delete;
+    void submit(VMProgram&& program, const Registers& registers, Callback callback) {
+        submit(std::make_shared<const VMProgram>(std::move(program)), registers, std::move(callback));
+    }
+    void submit(ProgramPtr program, const Registers& registers, Callback callback) {
+        Job job = make_job(std::move(program), registers);
+        job.callback = std::move(callback);
+        enqueue(std::move(job));
+    }
+    size_t worker_count() const { return workers_.size(); }
+    uint64_t steal_count() const { return steals_.load(std::memory_order_relaxed); }
+private:
+    struct Job {
+        ProgramPtr program;
+        Registers registers{};
+        uint32_t seed = 0;
+        std::optional<std::promise<VMJobResult>> promise;
+        Callback callback;
+    };
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+        std::thread thread;
+    };
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_{0};
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> steals_{0};
+    bool stopping_ = false;
+    uint32_t base_seed_;
+    EngineSetup setup_;
+    Job make_job(ProgramPtr program, const Registers& registers) {
+        Job job;
+        job.program = std::move(program);
+        job.registers = registers;
+        return job;
+    }
+    void enqueue(Job job) {
+        const uint64_t sequence = submitted_.fetch_add(1, std::memory_order_relaxed);
+        job.seed = vivisect::core::mix_seed(base_seed_, static_cast<uint32_t>(sequence));
+        Worker& worker = *workers_[sequence % workers_.size()];
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            pending_.fetch_add(1, std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.jobs.push_back(std::move(job));
+        }
+        wake_.notify_one();
+    }
+    std::optional<Job> pop(size_t index) {
+        Worker& worker = *workers_[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.jobs.empty()) return std::nullopt;
+        std::optional<Job> job(std::move(worker.jobs.back()));
+        worker.jobs.pop_back();
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+    }
+    std::optional<Job> steal(size_t index) {
+        for (size_t offset = 1; offset < workers_.size(); ++offset) {
+            Worker& victim = *workers_[(index + offset) % workers_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.jobs.empty()) continue;
+            std::optional<Job> job(std::move(victim.jobs.front()));
+            victim.jobs.pop_front();
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+        return std::nullopt;
+    }
+    void run(size_t index) {
+        int seed = 0;
+        VMEngine engine(seed);
+        if (setup_) setup_(engine);
+        while (true) {
+            std::optional<Job> job = pop(index);
+            if (!job) job = steal(index);
+            if (job) {
+                execute(engine, seed, *job);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            wake_.wait(lock, [this] { return stopping_ || pending_.load(std::memory_order_relaxed) > 0; });
+            if (stopping_ && pending_.load(std::memory_order_relaxed) == 0) return;
+        }
+    }
+    static void execute(VMEngine& engine, int& seed, Job& job) {
+        seed = static_cast<int>(job.seed);
+        engine.reset();
+        for (size_t i = 0; i < job.registers.size(); ++i) {
+            engine.set_register(static_cast<uint8_t>(i), job.registers[i]);
+        }
+        VMJobResult result;
+        if (job.program) {
+            result.status = engine.execute(*job.program);
+        } else {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Invalid bytecode or length");
+        }
+        for (size_t i = 0; i < result.registers.size(); ++i) {
+            result.registers[i] = engine.get_register(static_cast<uint8_t>(i));
+        }
+        job.program.reset();
+        if (job.callback) {
+            try {
+                job.callback(result);
+            } catch (const std::exception&) {
+                VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Executor callback failed");
+            }
+        } else {
+            job.promise->set_value(result);
+        }
+    }
+};
+}
+#endif
@@ -0,0 +1,53 @@
+#ifndef VIVISECT_MODULES_VM_HOST_HPP
+#define VIVISECT_MODULES_VM_HOST_HPP
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+namespace vivisect::modules {
+struct VMHostFunction {
+    using Thunk = uint32_t(*)(const uint32_t* args);
+    Thunk thunk = nullptr;
+    uint8_t arity = 0;
+    bool returns_value = false;
+};
+template<typename T>
+constexpr bool is_vm_host_value() {
+    if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+        return sizeof(T) <= sizeof(uint32_t);
+    } else {
+        return false;
+    }
+}
+template<typename T>
+inline constexpr bool is_vm_host_value_v = is_vm_host_value<T>();
+template<auto Fn, typename F = decltype(Fn)>
+struct VMHostSignature;
+template<auto Fn, typename R, typename... Args>
+struct VMHostSignature<Fn, R(*)(Args...)> {
+    static_assert(sizeof...(Args) <= 8, "VM: Host functions take at most 8 register arguments");
+    static_assert((is_vm_host_value_v<Args> && ...), "VM: Host function arguments must be 32-bit integral values");
+    static_assert(std::is_void_v<R> || is_vm_host_value_v<R>, "VM: Host function result must be void or a 32-bit integral value");
+    static constexpr uint8_t ARITY = static_cast<uint8_t>(sizeof...(Args));
+    static constexpr bool RETURNS_VALUE = !std::is_void_v<R>;
+    static uint32_t invoke(const uint32_t* args) {
+        return call(args, std::index_sequence_for<Args...>{});
+    }
+    static constexpr VMHostFunction descriptor() {
+        return VMHostFunction{&invoke, ARITY, RETURNS_VALUE};
+    }
+private:
+    template<size_t... I>
+    static uint32_t call([[maybe_unused]] const uint32_t* args, std::index_sequence<I...>) {
+        if constexpr (std::is_void_v<R>) {
+            Fn(static_cast<Args>(args[I])...);
+            return 0;
+        } else {
+            return static_cast<uint32_t>(Fn(static_cast<Args>(args[I])...));
+        }
+    }
+};
+template<auto Fn, typename R, typename... Args>
+struct VMHostSignature<Fn, R(*)(Args...) noexcept> : VMHostSignature<Fn, R(*)(Args...)> {};
+}
+#endif
@@ -0,0 +1,446 @@
+#ifndef VIVISECT_MODULES_VM_JIT_HPP
+#define VIVISECT_MODULES_VM_JIT_HPP
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <utility>
+#include "vm_engine.hpp"
+#include "../core/primitives.hpp"
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__linux__) || defined(__APPLE__) || defined(_WIN32))
+    #define VIVISECT_VM_JIT_AVAILABLE
+    #ifdef _WIN32
+        #include <windows.h>
+    #else
+        #include <sys/mman.h>
+    #endif
+#endif
+namespace vivisect::modules {
+struct VMJitOptions {
+    bool randomize_layout = true;
+    uint32_t layout_seed = static_cast<uint32_t>(vivisect::core::global_seed);
+};
+#ifdef VIVISECT_VM_JIT_AVAILABLE
+namespace detail {
+class VMJitAssembler {
+public:
+    VMJitAssembler(const VMProgram& program, const VMJitOptions& options)
+        : code_(program.data()), length_(program.size()), options_(options),
+          block_offsets_(program.size() + 2, 0) {
+        int seed = 0;
+        VMState probe(seed);
+        const char* base = reinterpret_cast<const char*>(&probe);
+        registers_offset_ = static_cast<int32_t>(reinterpret_cast<const char*>(&probe.registers) - base);
+        pc_offset_ = static_cast<int32_t>(reinterpret_cast<const char*>(&probe.pc) - base);
+        flags_offset_ = static_cast<int32_t>(reinterpret_cast<const char*>(&probe.flags) - base);
+        memory_offset_ = static_cast<int32_t>(reinterpret_cast<const char*>(&probe.memory) - base);
+        call_stack_offset_ = static_cast<int32_t>(reinterpret_cast<const char*>(&probe.call_stack) - base);
+        stack_ptr_offset_ = static_cast<int32_t>(reinterpret_cast<const char*>(&probe.stack_ptr) - base);
+    }
+    std::vector<uint8_t> assemble() {
+        for (size_t pc = 0; pc < length_; ++pc) {
+            if (!is_supported(code_[pc].opcode)) {
+                return {};
+            }
+        }
+        emit_prologue();
+        std::vector<size_t> order(length_);
+        for (size_t i = 0; i < length_; ++i) {
+            order[i] = i;
+        }
+        uint32_t seed = options_.layout_seed;
+        if (options_.randomize_layout) {
+            for (size_t i = length_; i > 1; --i) {
+                seed = seed * 1103515245 + 12345;
+                std::swap(order[i - 1], order[(seed >> 16) % i]);
+            }
+        }
+        emit_continue(0, order.empty() ? end_block() : order[0]);
+        for (size_t k = 0; k < length_; ++k) {
+            if (options_.randomize_layout) {
+                seed = seed * 1103515245 + 12345;
+                for (uint32_t pad = (seed >> 16) & 7; pad > 0; --pad) {
+                    emit8(0x90);
+                }
+            }
+            size_t pc = order[k];
+            block_offsets_[pc] = out_.size();
+            size_t physical_next = (k + 1 < length_) ? order[k + 1] : end_block();
+            emit_instruction(pc, physical_next);
+        }
+        block_offsets_[end_block()] = out_.size();
+        emit_mov_eax_imm(static_cast<uint32_t>(length_));
+        block_offsets_[exit_block()] = out_.size();
+        emit_store(0, pc_offset_);
+        emit_epilogue();
+        while (out_.size() % 4 != 0) {
+            emit8(0xCC);
+        }
+        size_t table_offset = out_.size();
+        for (size_t pc = 0; pc < length_; ++pc) {
+            emit32(static_cast<uint32_t>(static_cast<int32_t>(block_offsets_[pc]) - static_cast<int32_t>(table_offset)));
+        }
+        for (const Fixup& fixup : fixups_) {
+            size_t target = fixup.block == TABLE_FIXUP ? table_offset : block_offsets_[fixup.block];
+            int32_t rel = static_cast<int32_t>(target) - static_cast<int32_t>(fixup.position + 4);
+            std::memcpy(&out_[fixup.position], &rel, sizeof(rel));
+        }
+        return out_;
+    }
+private:
+    static constexpr size_t TABLE_FIXUP = static_cast<size_t>(-1);
+    static constexpr uint8_t EAX = 0;
+    static constexpr uint8_t ECX = 1;
+    static constexpr uint8_t EDX = 2;
+    struct Fixup {
+        size_t position;
+        size_t block;
+    };
+    const VMDecodedInstruction* code_;
+    size_t length_;
+    VMJitOptions options_;
+    std::vector<size_t> block_offsets_;
+    std::vector<Fixup> fixups_;
+    std::vector<uint8_t> out_;
+    int32_t registers_offset_ = 0;
+    int32_t pc_offset_ = 0;
+    int32_t flags_offset_ = 0;
+    int32_t memory_offset_ = 0;
+    int32_t call_stack_offset_ = 0;
+    int32_t stack_ptr_offset_ = 0;
+    static bool is_supported(uint16_t opcode) {
+        return (opcode < VMEngine::BUILTIN_HANDLER_COUNT && opcode != static_cast<uint16_t>(VMOpcode::HOST_CALL)) ||
+               (opcode >= static_cast<uint16_t>(VMFusedOpcode::LOAD_IMM_ALU) &&
+                opcode <= static_cast<uint16_t>(VMFusedOpcode::LOAD_ALU_STORE));
+    }
+    size_t end_block() const { return length_; }
+    size_t exit_block() const { return length_ + 1; }
+    int32_t reg_offset(uint8_t reg) const { return registers_offset_ + static_cast<int32_t>(reg) * 4; }
+    void emit8(uint8_t byte) { out_.push_back(byte); }
+    void emit32(uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out_.push_back(static_cast<uint8_t>(value >> (i * 8)));
+        }
+    }
+    void emit_rel32(size_t block) {
+        fixups_.push_back(Fixup{out_.size(), block});
+        emit32(0);
+    }
+    void emit_jump(size_t block) {
+        emit8(0xE9);
+        emit_rel32(block);
+    }
+    void emit_jcc(uint8_t condition, size_t block) {
+        emit8(0x0F);
+        emit8(condition);
+        emit_rel32(block);
+    }
+    void emit_load(uint8_t reg, int32_t disp) {
+        emit8(0x8B);
+        emit8(static_cast<uint8_t>(0x83 | (reg << 3)));
+        emit32(static_cast<uint32_t>(disp));
+    }
+    void emit_store(uint8_t reg, int32_t disp) {
+        emit8(0x89);
+        emit8(static_cast<uint8_t>(0x83 | (reg << 3)));
+        emit32(static_cast<uint32_t>(disp));
+    }
+    void emit_store_imm(int32_t disp, uint32_t imm) {
+        emit8(0xC7);
+        emit8(0x83);
+        emit32(static_cast<uint32_t>(disp));
+        emit32(imm);
+    }
+    void emit_mov_eax_imm(uint32_t imm) {
+        emit8(0xB8);
+        emit32(imm);
+    }
+    void emit_prologue() {
+        emit8(0x53);
+        emit8(0x41); emit8(0x54);
+#ifdef _WIN32
+        emit8(0x48); emit8(0x89); emit8(0xCB);
+        emit8(0x49); emit8(0x89); emit8(0xD4);
+#else
+        emit8(0x48); emit8(0x89); emit8(0xFB);
+        emit8(0x49); emit8(0x89); emit8(0xF4);
+#endif
+    }
+    void emit_epilogue() {
+        emit8(0x41); emit8(0x5C);
+        emit8(0x5B);
+        emit8(0xC3);
+    }
+    void emit_set_flags() {
+        emit8(0x85); emit8(0xC0);
+        emit8(0x0F); emit8(0x94); emit8(0xC2);
+        emit8(0x0F); emit8(0xB6); emit8(0xD2);
+        emit_store(EDX, flags_offset_);
+    }
+    void emit_alu(uint8_t op, uint8_t dest, uint8_t src1, uint8_t src2) {
+        emit_load(EAX, reg_offset(src1));
+        emit_load(ECX, reg_offset(src2));
+        switch (static_cast<VMOpcode>(op)) {
+            case VMOpcode::ADD: emit8(0x01); emit8(0xC8); break;
+            case VMOpcode::SUB: emit8(0x29); emit8(0xC8); break;
+            case VMOpcode::MUL: emit8(0x0F); emit8(0xAF); emit8(0xC1); break;
+            case VMOpcode::XOR: emit8(0x31); emit8(0xC8); break;
+            case VMOpcode::AND: emit8(0x21); emit8(0xC8); break;
+            case VMOpcode::OR:  emit8(0x09); emit8(0xC8); break;
+            case VMOpcode::NOT: emit8(0xF7); emit8(0xD0); break;
+            case VMOpcode::SHL: emit8(0xD3); emit8(0xE0); break;
+            case VMOpcode::SHR: emit8(0xD3); emit8(0xE8); break;
+            case VMOpcode::DIV: {
+                emit8(0x85); emit8(0xC9);
+                emit8(0x74);
+                size_t skip = out_.size();
+                emit8(0);
+                emit8(0x31); emit8(0xD2);
+                emit8(0xF7); emit8(0xF1);
+                emit_store(EAX, reg_offset(dest));
+                emit_set_flags();
+                out_[skip] = static_cast<uint8_t>(out_.size() - (skip + 1));
+                return;
+            }
+            default: break;
+        }
+        emit_store(EAX, reg_offset(dest));
+        emit_set_flags();
+    }
+    void emit_memory_load(uint8_t dest, uint8_t addr_reg) {
+        emit_load(ECX, reg_offset(addr_reg));
+        emit8(0x81); emit8(0xF9); emit32(256);
+        emit8(0x73);
+        size_t skip = out_.size();
+        emit8(0);
+        emit8(0x8B); emit8(0x84); emit8(0x8B); emit32(static_cast<uint32_t>(memory_offset_));
+        emit_store(EAX, reg_offset(dest));
+        out_[skip] = static_cast<uint8_t>(out_.size() - (skip + 1));
+    }
+    void emit_memory_store(uint8_t addr_reg, uint8_t src) {
+        emit_load(ECX, reg_offset(addr_reg));
+        emit8(0x81); emit8(0xF9); emit32(256);
+        emit8(0x73);
+        size_t skip = out_.size();
+        emit8(0);
+        emit_load(EAX, reg_offset(src));
+        emit8(0x89); emit8(0x84); emit8(0x8B); emit32(static_cast<uint32_t>(memory_offset_));
+        out_[skip] = static_cast<uint8_t>(out_.size() - (skip + 1));
+    }
+    void emit_conditional(uint8_t reg, bool jump_if_zero, uint32_t target, size_t fallthrough, size_t physical_next) {
+        emit_load(EAX, reg_offset(reg));
+        emit8(0x85); emit8(0xC0);
+        emit_jcc(jump_if_zero ? 0x84 : 0x85, target);
+        emit_continue(fallthrough, physical_next);
+    }
+    void emit_continue(size_t next, size_t physical_next) {
+        if (next != physical_next) {
+            emit_jump(next);
+        }
+    }
+    void emit_instruction(size_t pc, size_t physical_next) {
+        const VMDecodedInstruction& inst = code_[pc];
+        const size_t next = pc + 1;
+        switch (inst.opcode) {
+            case static_cast<uint16_t>(VMOpcode::ADD):
+            case static_cast<uint16_t>(VMOpcode::SUB):
+            case static_cast<uint16_t>(VMOpcode::MUL):
+            case static_cast<uint16_t>(VMOpcode::DIV):
+            case static_cast<uint16_t>(VMOpcode::XOR):
+            case static_cast<uint16_t>(VMOpcode::AND):
+            case static_cast<uint16_t>(VMOpcode::OR):
+            case static_cast<uint16_t>(VMOpcode::NOT):
+            case static_cast<uint16_t>(VMOpcode::SHL):
+            case static_cast<uint16_t>(VMOpcode::SHR):
+                emit_alu(static_cast<uint8_t>(inst.opcode), inst.dest_reg, inst.src1_reg, inst.src2_reg);
+                break;
+            case static_cast<uint16_t>(VMOpcode::LOAD):
+                emit_memory_load(inst.dest_reg, inst.src1_reg);
+                break;
+            case static_cast<uint16_t>(VMOpcode::STORE):
+                emit_memory_store(inst.dest_reg, inst.src1_reg);
+                break;
+            case static_cast<uint16_t>(VMOpcode::LOAD_IMM):
+                emit_store_imm(reg_offset(inst.dest_reg), inst.immediate);
+                break;
+            case static_cast<uint16_t>(VMOpcode::JUMP):
+                emit_continue(inst.immediate, physical_next);
+                return;
+            case static_cast<uint16_t>(VMOpcode::JUMP_IF_ZERO):
+                emit_conditional(inst.src1_reg, true, inst.immediate, next, physical_next);
+                return;
+            case static_cast<uint16_t>(VMOpcode::JUMP_IF_NOT_ZERO):
+                emit_conditional(inst.src1_reg, false, inst.immediate, next, physical_next);
+                return;
+            case static_cast<uint16_t>(VMOpcode::CALL):
+                emit_load(EDX, stack_ptr_offset_);
+                emit8(0x83); emit8(0xFA); emit8(32);
+                emit_jcc(0x83, pc);
+                emit8(0xC7); emit8(0x84); emit8(0x93);
+                emit32(static_cast<uint32_t>(call_stack_offset_));
+                emit32(static_cast<uint32_t>(pc + 1));
+                emit8(0xFF); emit8(0xC2);
+                emit_store(EDX, stack_ptr_offset_);
+                emit_continue(inst.immediate, physical_next);
+                return;
+            case static_cast<uint16_t>(VMOpcode::RET):
+                emit_load(EDX, stack_ptr_offset_);
+                emit8(0x85); emit8(0xD2);
+                emit_jcc(0x84, pc);
+                emit8(0xFF); emit8(0xCA);
+                emit_store(EDX, stack_ptr_offset_);
+                emit8(0x8B); emit8(0x84); emit8(0x93);
+                emit32(static_cast<uint32_t>(call_stack_offset_));
+                emit8(0x3D); emit32(static_cast<uint32_t>(length_));
+                emit_jcc(0x83, exit_block());
+                emit8(0x48); emit8(0x8D); emit8(0x0D);
+                emit_rel32(TABLE_FIXUP);
+                emit8(0x48); emit8(0x63); emit8(0x14); emit8(0x81);
+                emit8(0x48); emit8(0x01); emit8(0xCA);
+                emit8(0xFF); emit8(0xE2);
+                return;
+            case static_cast<uint16_t>(VMOpcode::MANGLE_KEY):
+                emit_load(EAX, reg_offset(inst.src1_reg));
+                emit8(0x41); emit8(0x8B); emit8(0x14); emit8(0x24);
+                emit8(0x31); emit8(0xD0);
+                emit8(0x69); emit8(0xC0); emit32(0x9e3779b9);
+                emit_store(EAX, reg_offset(inst.dest_reg));
+                break;
+            case static_cast<uint16_t>(VMOpcode::JUNK_OP):
+                emit_load(EAX, reg_offset(0));
+                emit8(0x69); emit8(0xC0); emit32(0x9e3779b9);
+                emit8(0x35); emit32(0xDEADBEEF);
+                emit8(0xC1); emit8(0xC0); emit8(13);
+                break;
+            case static_cast<uint16_t>(VMOpcode::NOP):
+                emit8(0x90);
+                break;
+            case static_cast<uint16_t>(VMFusedOpcode::LOAD_IMM_ALU):
+                emit_store_imm(reg_offset(inst.fused_regs[0]), inst.immediate);
+                emit_alu(inst.fused_op, inst.dest_reg, inst.src1_reg, inst.src2_reg);
+                break;
+            case static_cast<uint16_t>(VMFusedOpcode::ALU_JUMP_IF_ZERO):
+            case static_cast<uint16_t>(VMFusedOpcode::ALU_JUMP_IF_NOT_ZERO):
+                emit_alu(inst.fused_op, inst.dest_reg, inst.src1_reg, inst.src2_reg);
+                emit_conditional(inst.fused_regs[0],
+                                 inst.opcode == static_cast<uint16_t>(VMFusedOpcode::ALU_JUMP_IF_ZERO),
+                                 inst.immediate, next, physical_next);
+                return;
+            case static_cast<uint16_t>(VMFusedOpcode::LOAD_ALU_STORE):
+                emit_memory_load(inst.fused_regs[0], inst.fused_regs[1]);
+                emit_alu(inst.fused_op, inst.dest_reg, inst.src1_reg, inst.src2_reg);
+                emit_memory_store(inst.fused_regs[2], inst.fused_regs[3]);
+                break;
+            default:
+                return;
+        }
+        emit_continue(next, physical_next);
+    }
+};
+}
+#endif
+class VMJitProgram {
+public:
+    using NativeFunction = void(*)(VMState*, int*);
+    static VMJitProgram compile(const VMProgram& program, const VMJitOptions& options = {}) {
+        VMJitProgram jit(program);
+#ifdef VIVISECT_VM_JIT_AVAILABLE
+        detail::VMJitAssembler assembler(program, options);
+        std::vector<uint8_t> code = assembler.assemble();
+        jit.map_native(code);
+#endif
+        return jit;
+    }
+    VMJitProgram(VMJitProgram&& other) noexcept
+        : program_(std::move(other.program_)), native_(other.native_),
+          region_(other.region_), region_size_(other.region_size_) {
+        other.native_ = nullptr;
+        other.region_ = nullptr;
+        other.region_size_ = 0;
+    }
+    VMJitProgram& operator=(VMJitProgram&& other) noexcept {
+        if (this != &other) {
+            release();
+            program_ = std::move(other.program_);
+            native_ = other.native_;
+            region_ = other.region_;
+            region_size_ = other.region_size_;
+            other.native_ = nullptr;
+            other.region_ = nullptr;
+            other.region_size_ = 0;
+        }
+        return *this;
+    }
+    VMJitProgram(const VMJitProgram&) = delete;
+    VMJitProgram& operator=(const VMJitProgram&) = delete;
+    ~VMJitProgram() {
+        release();
+    }
+    void execute(VMEngine& engine) const {
+        if (native_) {
+            VMState& state = engine.get_state();
+            state.load_seed();
+            native_(&state, &state.global_seed);
+            state.store_seed();
+            return;
+        }
+        engine.execute(program_);
+    }
+    bool is_native() const { return native_ != nullptr; }
+    size_t native_size() const { return region_size_; }
+    const VMProgram& program() const { return program_; }
+private:
+    explicit VMJitProgram(const VMProgram& program) : program_(program) {}
+    VMProgram program_;
+    NativeFunction native_ = nullptr;
+    void* region_ = nullptr;
+    size_t region_size_ = 0;
+#ifdef VIVISECT_VM_JIT_AVAILABLE
+    void map_native(const std::vector<uint8_t>& code) {
+        if (code.empty()) {
+            return;
+        }
+#ifdef _WIN32
+        void* region = VirtualAlloc(nullptr, code.size(), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (!region) {
+            return;
+        }
+        std::memcpy(region, code.data(), code.size());
+        DWORD old_protect = 0;
+        if (!VirtualProtect(region, code.size(), PAGE_EXECUTE_READ, &old_protect)) {
+            VirtualFree(region, 0, MEM_RELEASE);
+            return;
+        }
+        FlushInstructionCache(GetCurrentProcess(), region, code.size());
+#else
+        void* region = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (region == MAP_FAILED) {
+            return;
+        }
+        std::memcpy(region, code.data(), code.size());
+        if (mprotect(region, code.size(), PROT_READ | PROT_EXEC) != 0) {
+            munmap(region, code.size());
+            return;
+        }
+#endif
+        region_ = region;
+        region_size_ = code.size();
+        native_ = reinterpret_cast<NativeFunction>(region);
+    }
+#endif
+    void release() {
+#ifdef VIVISECT_VM_JIT_AVAILABLE
+        if (region_) {
+#ifdef _WIN32
+            VirtualFree(region_, 0, MEM_RELEASE);
+#else
+            munmap(region_, region_size_);
+#endif
+        }
+#endif
+        native_ = nullptr;
+        region_ = nullptr;
+        region_size_ = 0;
+    }
+};
+}
+#endif
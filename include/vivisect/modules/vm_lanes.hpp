@@ -0,0 +1,346 @@
+#ifndef VIVISECT_MODULES_VM_LANES_HPP
+#define VIVISECT_MODULES_VM_LANES_HPP
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "vm_engine.hpp"
+#include "../core/simd.hpp"
+#include "../core/primitives.hpp"
+#include "../error/error.hpp"
+namespace vivisect::modules {
+template<size_t Lanes = 16>
+class VMLaneEngine {
+public:
+    using Vec = core::simd::U32Vec;
+    static constexpr size_t LANES = Lanes;
+    static constexpr size_t GROUPS = Lanes / Vec::WIDTH;
+    static constexpr uint32_t ALL_LANES = Lanes == 32 ? 0xFFFFFFFFu : ((1u << Lanes) - 1);
+    static_assert(Lanes % Vec::WIDTH == 0 && Lanes <= 32, "Lane count must be a multiple of the vector width and at most 32");
+    struct State {
+        alignas(32) uint32_t registers[8][Lanes];
+        alignas(32) uint32_t flags[Lanes];
+        uint32_t pc[Lanes];
+        uint32_t stack_ptr[Lanes];
+        alignas(32) uint32_t memory[256][Lanes];
+        uint32_t call_stack[32][Lanes];
+    };
+    explicit VMLaneEngine(int& seed_ref) : global_seed_(seed_ref), dispatch_count_(0) {
+        std::memset(&state_, 0, sizeof(state_));
+    }
+    void reset() {
+        std::memset(&state_, 0, offsetof(State, memory));
+        for (size_t word = 0; word < 4; ++word) {
+            for (uint64_t bits = dirty_rows_[word]; bits != 0; bits &= bits - 1) {
+                std::memset(state_.memory[word * 64 + std::countr_zero(bits)], 0, sizeof(state_.memory[0]));
+            }
+            dirty_rows_[word] = 0;
+        }
+        std::memset(state_.call_stack, 0, stack_depth_ * sizeof(state_.call_stack[0]));
+        stack_depth_ = 0;
+        dispatch_count_ = 0;
+    }
+    uint32_t* lane_register(uint8_t reg) { return state_.registers[reg]; }
+    const uint32_t* lane_register(uint8_t reg) const { return state_.registers[reg]; }
+    uint32_t* lane_memory(uint8_t addr) {
+        mark_dirty(addr);
+        return state_.memory[addr];
+    }
+    const uint32_t* lane_memory(uint8_t addr) const { return state_.memory[addr]; }
+    const State& get_state() const { return state_; }
+    uint64_t get_dispatch_count() const { return dispatch_count_; }
+    VMRunStatus execute(const VMProgram& program, uint32_t active = ALL_LANES) {
+        if (program.empty()) {
+            VIVISECT_ERROR(error::ErrorCode::VM_EXECUTION_ERROR, "VM: Invalid bytecode or length");
+            return VMRunStatus::FAULTED;
+        }
+        const VMDecodedInstruction* code = program.data();
+        const uint32_t length = static_cast<uint32_t>(program.size());
+        live_ = active & ALL_LANES;
+        for (size_t l = 0; l < Lanes; ++l) {
+            state_.pc[l] = ((live_ >> l) & 1) ? 0 : length;
+        }
+        pc_ = 0;
+        mask_ = live_;
+        while (mask_ != 0) {
+            const VMDecodedInstruction& inst = code[pc_];
+            ++dispatch_count_;
+            switch (inst.opcode) {
+                case static_cast<uint16_t>(VMOpcode::ADD):
+                case static_cast<uint16_t>(VMOpcode::SUB):
+                case static_cast<uint16_t>(VMOpcode::MUL):
+                case static_cast<uint16_t>(VMOpcode::XOR):
+                case static_cast<uint16_t>(VMOpcode::AND):
+                case static_cast<uint16_t>(VMOpcode::OR):
+                case static_cast<uint16_t>(VMOpcode::NOT):
+                case static_cast<uint16_t>(VMOpcode::SHL):
+                case static_cast<uint16_t>(VMOpcode::SHR):
+                    alu(inst.opcode, inst.dest_reg, inst.src1_reg, inst.src2_reg);
+                    advance(length);
+                    break;
+                case static_cast<uint16_t>(VMOpcode::DIV):
+                    div(inst.dest_reg, inst.src1_reg, inst.src2_reg);
+                    advance(length);
+                    break;
+                case static_cast<uint16_t>(VMOpcode::LOAD):
+                    load(inst.dest_reg, inst.src1_reg);
+                    advance(length);
+                    break;
+                case static_cast<uint16_t>(VMOpcode::STORE):
+                    store(inst.dest_reg, inst.src1_reg);
+                    advance(length);
+                    break;
+                case static_cast<uint16_t>(VMOpcode::LOAD_IMM):
+                    write_masked(state_.registers[inst.dest_reg], [&](size_t) { return Vec::broadcast(inst.immediate); });
+                    advance(length);
+                    break;
+                case static_cast<uint16_t>(VMOpcode::MANGLE_KEY):
+                    mangle_key(inst.dest_reg, inst.src1_reg);
+                    advance(length);
+                    break;
+                case static_cast<uint16_t>(VMOpcode::JUNK_OP):
+                case static_cast<uint16_t>(VMOpcode::NOP):
+                    vivisect::core::volatile_nop();
+                    advance(length);
+                    break;
+                case static_cast<uint16_t>(VMOpcode::JUMP):
+                    branch(mask_, inst.immediate, length);
+                    break;
+                case static_cast<uint16_t>(VMOpcode::JUMP_IF_ZERO):
+                    branch(zero_lanes(inst.src1_reg), inst.immediate, length);
+                    break;
+                case static_cast<uint16_t>(VMOpcode::JUMP_IF_NOT_ZERO):
+                    branch(mask_ & ~zero_lanes(inst.src1_reg), inst.immediate, length);
+                    break;
+                case static_cast<uint16_t>(VMOpcode::CALL):
+                    call(inst.immediate, length);
+                    break;
+                case static_cast<uint16_t>(VMOpcode::RET):
+                    ret(length);
+                    break;
+                case static_cast<uint16_t>(VMFusedOpcode::LOAD_IMM_ALU):
+                    write_masked(state_.registers[inst.fused_regs[0]], [&](size_t) { return Vec::broadcast(inst.immediate); });
+                    alu(inst.fused_op, inst.dest_reg, inst.src1_reg, inst.src2_reg);
+                    advance(length);
+                    break;
+                case static_cast<uint16_t>(VMFusedOpcode::ALU_JUMP_IF_ZERO):
+                    alu(inst.fused_op, inst.dest_reg, inst.src1_reg, inst.src2_reg);
+                    branch(zero_lanes(inst.fused_regs[0]), inst.immediate, length);
+                    break;
+                case static_cast<uint16_t>(VMFusedOpcode::ALU_JUMP_IF_NOT_ZERO):
+                    alu(inst.fused_op, inst.dest_reg, inst.src1_reg, inst.src2_reg);
+                    branch(mask_ & ~zero_lanes(inst.fused_regs[0]), inst.immediate, length);
+                    break;
+                case static_cast<uint16_t>(VMFusedOpcode::LOAD_ALU_STORE):
+                    load(inst.fused_regs[0], inst.fused_regs[1]);
+                    alu(inst.fused_op, inst.dest_reg, inst.src1_reg, inst.src2_reg);
+                    store(inst.fused_regs[2], inst.fused_regs[3]);
+                    advance(length);
+                    break;
+                default:
+                    VIVISECT_ERROR(error::ErrorCode::VM_INVALID_OPCODE, "VM: Invalid or unregistered opcode");
+                    return VMRunStatus::FAULTED;
+            }
+        }
+        return VMRunStatus::COMPLETED;
+    }
+    VMRunStatus execute_batch(const VMProgram& program,
+                              uint8_t input_reg, const uint32_t* inputs,
+                              uint8_t output_reg, uint32_t* outputs, size_t count) {
+        if (input_reg >= 8 || output_reg >= 8) {
+            VIVISECT_ERROR(error::ErrorCode::VM_INVALID_REGISTER, "VM: Invalid register index");
+            return VMRunStatus::FAULTED;
+        }
+        for (size_t base = 0; base < count; base += Lanes) {
+            const size_t n = (count - base < Lanes) ? count - base : Lanes;
+            reset();
+            std::memcpy(state_.registers[input_reg], inputs + base, n * sizeof(uint32_t));
+            const uint32_t active = n == Lanes ? ALL_LANES : ((1u << n) - 1);
+            VMRunStatus status = execute(program, active);
+            if (status != VMRunStatus::COMPLETED) {
+                return status;
+            }
+            std::memcpy(outputs + base, state_.registers[output_reg], n * sizeof(uint32_t));
+        }
+        return VMRunStatus::COMPLETED;
+    }
+private:
+    State state_;
+    int& global_seed_;
+    uint64_t dispatch_count_;
+    uint32_t pc_ = 0;
+    uint32_t mask_ = 0;
+    uint32_t live_ = 0;
+    uint64_t dirty_rows_[4] = {};
+    uint32_t stack_depth_ = 0;
+    void mark_dirty(uint32_t row) {
+        dirty_rows_[row >> 6] |= uint64_t{1} << (row & 63);
+    }
+    template<typename Fn>
+    void write_masked(uint32_t* row, Fn value) {
+        for (size_t g = 0; g < GROUPS; ++g) {
+            const size_t offset = g * Vec::WIDTH;
+            Vec v = value(offset);
+            if (mask_ != ALL_LANES) {
+                v = core::simd::select(Vec::from_bits(mask_ >> offset), v, Vec::load(row + offset));
+            }
+            v.store(row + offset);
+        }
+    }
+    template<typename Fn>
+    void alu_masked(uint8_t dest, uint8_t src1, uint8_t src2, Fn fn) {
+        const Vec one = Vec::broadcast(1);
+        for (size_t g = 0; g < GROUPS; ++g) {
+            const size_t offset = g * Vec::WIDTH;
+            Vec result = fn(Vec::load(state_.registers[src1] + offset), Vec::load(state_.registers[src2] + offset));
+            Vec flags = core::simd::bit_and(core::simd::is_zero(result), one);
+            if (mask_ != ALL_LANES) {
+                Vec m = Vec::from_bits(mask_ >> offset);
+                result = core::simd::select(m, result, Vec::load(state_.registers[dest] + offset));
+                flags = core::simd::select(m, flags, Vec::load(state_.flags + offset));
+            }
+            result.store(state_.registers[dest] + offset);
+            flags.store(state_.flags + offset);
+        }
+    }
+    void alu(uint16_t op, uint8_t dest, uint8_t src1, uint8_t src2) {
+        using namespace core::simd;
+        switch (static_cast<VMOpcode>(op)) {
+            case VMOpcode::ADD: alu_masked(dest, src1, src2, [](Vec a, Vec b) { return add(a, b); }); break;
+            case VMOpcode::SUB: alu_masked(dest, src1, src2, [](Vec a, Vec b) { return sub(a, b); }); break;
+            case VMOpcode::MUL: alu_masked(dest, src1, src2, [](Vec a, Vec b) { return mul(a, b); }); break;
+            case VMOpcode::XOR: alu_masked(dest, src1, src2, [](Vec a, Vec b) { return bit_xor(a, b); }); break;
+            case VMOpcode::AND: alu_masked(dest, src1, src2, [](Vec a, Vec b) { return bit_and(a, b); }); break;
+            case VMOpcode::OR:  alu_masked(dest, src1, src2, [](Vec a, Vec b) { return bit_or(a, b); }); break;
+            case VMOpcode::NOT: alu_masked(dest, src1, src2, [](Vec a, Vec) { return bit_not(a); }); break;
+            case VMOpcode::SHL: alu_masked(dest, src1, src2, [](Vec a, Vec b) { return shl(a, b); }); break;
+            case VMOpcode::SHR: alu_masked(dest, src1, src2, [](Vec a, Vec b) { return shr(a, b); }); break;
+            default: break;
+        }
+    }
+    void mangle_key(uint8_t dest, uint8_t src1) {
+        const Vec seed = Vec::broadcast(static_cast<uint32_t>(global_seed_));
+        const Vec golden = Vec::broadcast(0x9e3779b9);
+        write_masked(state_.registers[dest], [&](size_t offset) {
+            return core::simd::mul(core::simd::bit_xor(Vec::load(state_.registers[src1] + offset), seed), golden);
+        });
+    }
+    void div(uint8_t dest, uint8_t src1, uint8_t src2) {
+        for (uint32_t bits = mask_; bits != 0; bits &= bits - 1) {
+            const size_t l = lowest_lane(bits);
+            const uint32_t divisor = state_.registers[src2][l];
+            if (divisor != 0) {
+                state_.registers[dest][l] = state_.registers[src1][l] / divisor;
+                state_.flags[l] = (state_.registers[dest][l] == 0) ? 1 : 0;
+            }
+        }
+    }
+    void load(uint8_t dest, uint8_t src1) {
+        for (uint32_t bits = mask_; bits != 0; bits &= bits - 1) {
+            const size_t l = lowest_lane(bits);
+            const uint32_t addr = state_.registers[src1][l];
+            if (addr < 256) {
+                state_.registers[dest][l] = state_.memory[addr][l];
+            }
+        }
+    }
+    void store(uint8_t dest, uint8_t src1) {
+        for (uint32_t bits = mask_; bits != 0; bits &= bits - 1) {
+            const size_t l = lowest_lane(bits);
+            const uint32_t addr = state_.registers[dest][l];
+            if (addr < 256) {
+                mark_dirty(addr);
+                state_.memory[addr][l] = state_.registers[src1][l];
+            }
+        }
+    }
+    uint32_t zero_lanes(uint8_t reg) const {
+        uint32_t bits = 0;
+        for (size_t g = 0; g < GROUPS; ++g) {
+            const size_t offset = g * Vec::WIDTH;
+            bits |= core::simd::is_zero(Vec::load(state_.registers[reg] + offset)).to_bits() << offset;
+        }
+        return bits & mask_;
+    }
+    void call(uint32_t target, uint32_t length) {
+        for (uint32_t bits = mask_; bits != 0; bits &= bits - 1) {
+            const size_t l = lowest_lane(bits);
+            if (state_.stack_ptr[l] < 32) {
+                state_.call_stack[state_.stack_ptr[l]++][l] = pc_ + 1;
+                state_.pc[l] = target;
+                if (state_.stack_ptr[l] > stack_depth_) {
+                    stack_depth_ = state_.stack_ptr[l];
+                }
+            } else {
+                state_.pc[l] = pc_;
+            }
+        }
+        reschedule(length);
+    }
+    void ret(uint32_t length) {
+        for (uint32_t bits = mask_; bits != 0; bits &= bits - 1) {
+            const size_t l = lowest_lane(bits);
+            state_.pc[l] = state_.stack_ptr[l] > 0 ? state_.call_stack[--state_.stack_ptr[l]][l] : pc_;
+        }
+        reschedule(length);
+    }
+    void advance(uint32_t length) {
+        ++pc_;
+        if (pc_ >= length) {
+            retire(length);
+            return;
+        }
+        const uint32_t waiting = live_ & ~mask_;
+        for (uint32_t bits = waiting; bits != 0; bits &= bits - 1) {
+            const size_t l = lowest_lane(bits);
+            if (state_.pc[l] == pc_) {
+                mask_ |= 1u << l;
+            }
+        }
+    }
+    void branch(uint32_t taken, uint32_t target, uint32_t length) {
+        if ((taken == mask_ || taken == 0) && mask_ == live_) {
+            pc_ = taken ? target : pc_ + 1;
+            if (pc_ >= length) {
+                retire(length);
+            }
+            return;
+        }
+        for (uint32_t bits = mask_; bits != 0; bits &= bits - 1) {
+            const size_t l = lowest_lane(bits);
+            state_.pc[l] = ((taken >> l) & 1) ? target : pc_ + 1;
+        }
+        reschedule(length);
+    }
+    void retire(uint32_t length) {
+        for (uint32_t bits = mask_; bits != 0; bits &= bits - 1) {
+            state_.pc[lowest_lane(bits)] = pc_;
+        }
+        live_ &= ~mask_;
+        reschedule(length);
+    }
+    void reschedule(uint32_t length) {
+        uint32_t next = length;
+        for (uint32_t bits = live_; bits != 0; bits &= bits - 1) {
+            const size_t l = lowest_lane(bits);
+            if (state_.pc[l] >= length) {
+                live_ &= ~(1u << l);
+            } else if (state_.pc[l] < next) {
+                next = state_.pc[l];
+            }
+        }
+        pc_ = next;
+        mask_ = 0;
+        for (uint32_t bits = live_; bits != 0; bits &= bits - 1) {
+            const size_t l = lowest_lane(bits);
+            if (state_.pc[l] == next) {
+                mask_ |= 1u << l;
+            }
+        }
+    }
+    static size_t lowest_lane(uint32_t bits) {
+        return static_cast<size_t>(std::countr_zero(bits));
+    }
+};
+}
+#endif
@@ -0,0 +1,175 @@
+#ifndef VIVISECT_MODULES_VM_OPTIMIZER_HPP
+#define VIVISECT_MODULES_VM_OPTIMIZER_HPP
+#include <cstdint>
+#include <vector>
+#include "vm_engine.hpp"
+#include "vm_cfg.hpp"
+#include "../core/config.hpp"
+namespace vivisect::modules {
+struct VMOptimizerOptions {
+    bool fuse_superinstructions = true;
+    bool strip_junk = false;
+    bool eliminate_dead_code = false;
+    static VMOptimizerOptions from_profile(const config::ObfuscationProfile& profile) {
+        VMOptimizerOptions options;
+        options.strip_junk = !profile.enable_junk_code;
+        return options;
+    }
+};
+struct VMOptimizationReport {
+    size_t dispatches_before = 0;
+    size_t dispatches_after = 0;
+    size_t fused_sequences = 0;
+    size_t stripped_instructions = 0;
+    size_t eliminated_instructions = 0;
+};
+class VMPeepholeOptimizer {
+public:
+    static VMProgram optimize(const VMProgram& program,
+                              const VMOptimizerOptions& options = {},
+                              VMOptimizationReport* report = nullptr) {
+        if (options.eliminate_dead_code) {
+            VMDeadCodeReport dead_code;
+            VMOptimizerOptions remaining = options;
+            remaining.eliminate_dead_code = false;
+            VMProgram result = optimize(VMDeadCodeEliminator::optimize(program, &dead_code), remaining, report);
+            if (report) {
+                report->dispatches_before = program.size();
+                report->eliminated_instructions = dead_code.instructions_before - dead_code.instructions_after;
+            }
+            return result;
+        }
+        const VMDecodedInstruction* code = program.data();
+        const size_t length = program.size();
+        std::vector<bool> is_target(length + 1, false);
+        for (size_t pc = 0; pc < length; ++pc) {
+            if (has_remappable_target(code[pc])) {
+                is_target[code[pc].immediate] = true;
+            }
+            if (code[pc].opcode == static_cast<uint16_t>(VMOpcode::CALL)) {
+                is_target[pc + 1] = true;
+            }
+        }
+        VMProgram result;
+        result.code_.reserve(length);
+        std::vector<uint32_t> new_index(length + 1, 0);
+        std::vector<size_t> branch_sites;
+        size_t fused = 0;
+        size_t stripped = 0;
+        size_t pc = 0;
+        while (pc < length) {
+            const uint32_t index = static_cast<uint32_t>(result.code_.size());
+            new_index[pc] = index;
+            const VMDecodedInstruction& inst = code[pc];
+            VMOpcode op = opcode_of(inst);
+            if (options.strip_junk && (op == VMOpcode::NOP || op == VMOpcode::JUNK_OP)) {
+                ++stripped;
+                ++pc;
+                continue;
+            }
+            size_t consumed = 0;
+            if (options.fuse_superinstructions) {
+                consumed = try_fuse(code, length, pc, is_target, result.code_);
+            }
+            if (consumed > 0) {
+                for (size_t k = 1; k < consumed; ++k) {
+                    new_index[pc + k] = index;
+                }
+                ++fused;
+                pc += consumed;
+            } else {
+                result.code_.push_back(inst);
+                ++pc;
+            }
+            const VMDecodedInstruction& emitted = result.code_.back();
+            if (has_remappable_target(emitted)) {
+                branch_sites.push_back(result.code_.size() - 1);
+            }
+        }
+        new_index[length] = static_cast<uint32_t>(result.code_.size());
+        for (size_t site : branch_sites) {
+            VMDecodedInstruction& inst = result.code_[site];
+            inst.immediate = new_index[inst.immediate];
+        }
+        if (result.code_.empty()) {
+            result.code_.push_back(VMDecodedInstruction{
+                static_cast<uint16_t>(VMOpcode::NOP), 0, 0, 0, 0, {}, 0
+            });
+        }
+        if (report) {
+            report->dispatches_before = length;
+            report->dispatches_after = result.code_.size();
+            report->fused_sequences = fused;
+            report->stripped_instructions = stripped;
+        }
+        return result;
+    }
+private:
+    static VMOpcode opcode_of(const VMDecodedInstruction& inst) {
+        return static_cast<VMOpcode>(inst.opcode);
+    }
+    static bool has_remappable_target(const VMDecodedInstruction& inst) {
+        if (inst.opcode == static_cast<uint16_t>(VMFusedOpcode::ALU_JUMP_IF_ZERO) ||
+            inst.opcode == static_cast<uint16_t>(VMFusedOpcode::ALU_JUMP_IF_NOT_ZERO)) {
+            return true;
+        }
+        return inst.opcode < VMEngine::HANDLER_TABLE_SIZE &&
+               VMBuiltinHandlers::has_branch_target(opcode_of(inst));
+    }
+    static bool fusable_alu(const VMDecodedInstruction& inst) {
+        return inst.opcode < VMEngine::HANDLER_TABLE_SIZE &&
+               VMBuiltinHandlers::is_fusable_alu(opcode_of(inst));
+    }
+    static VMDecodedInstruction make_fused(VMFusedOpcode fused_op, const VMDecodedInstruction& alu) {
+        VMDecodedInstruction inst{};
+        inst.opcode = static_cast<uint16_t>(fused_op);
+        inst.dest_reg = alu.dest_reg;
+        inst.src1_reg = alu.src1_reg;
+        inst.src2_reg = alu.src2_reg;
+        inst.fused_op = static_cast<uint8_t>(alu.opcode);
+        return inst;
+    }
+    static size_t try_fuse(const VMDecodedInstruction* code, size_t length, size_t pc,
+                           const std::vector<bool>& is_target,
+                           std::vector<VMDecodedInstruction>& out) {
+        const VMDecodedInstruction& first = code[pc];
+        VMOpcode op = opcode_of(first);
+        if (pc + 2 < length && !is_target[pc + 1] && !is_target[pc + 2] &&
+            op == VMOpcode::LOAD && fusable_alu(code[pc + 1]) &&
+            opcode_of(code[pc + 2]) == VMOpcode::STORE) {
+            const VMDecodedInstruction& store = code[pc + 2];
+            VMDecodedInstruction inst = make_fused(VMFusedOpcode::LOAD_ALU_STORE, code[pc + 1]);
+            inst.fused_regs[0] = first.dest_reg;
+            inst.fused_regs[1] = first.src1_reg;
+            inst.fused_regs[2] = store.dest_reg;
+            inst.fused_regs[3] = store.src1_reg;
+            out.push_back(inst);
+            return 3;
+        }
+        if (pc + 1 >= length || is_target[pc + 1]) {
+            return 0;
+        }
+        const VMDecodedInstruction& second = code[pc + 1];
+        if (op == VMOpcode::LOAD_IMM && fusable_alu(second)) {
+            VMDecodedInstruction inst = make_fused(VMFusedOpcode::LOAD_IMM_ALU, second);
+            inst.fused_regs[0] = first.dest_reg;
+            inst.immediate = first.immediate;
+            out.push_back(inst);
+            return 2;
+        }
+        if (fusable_alu(first) &&
+            (opcode_of(second) == VMOpcode::JUMP_IF_ZERO || opcode_of(second) == VMOpcode::JUMP_IF_NOT_ZERO)) {
+            VMFusedOpcode fused_op = opcode_of(second) == VMOpcode::JUMP_IF_ZERO
+                ? VMFusedOpcode::ALU_JUMP_IF_ZERO
+                : VMFusedOpcode::ALU_JUMP_IF_NOT_ZERO;
+            VMDecodedInstruction inst = make_fused(fused_op, first);
+            inst.fused_regs[0] = second.src1_reg;
+            inst.immediate = second.immediate;
+            out.push_back(inst);
+            return 2;
+        }
+        return 0;
+    }
+};
+}
+#endif
@@ -0,0 +1,122 @@
+#ifndef VIVISECT_MODULES_VM_PROFILE_HPP
+#define VIVISECT_MODULES_VM_PROFILE_HPP
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <ostream>
+#ifdef VIVISECT_VM_PROFILING
+    #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        #include <intrin.h>
+        #define VIVISECT_VM_PROFILE_RDTSC
+    #elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        #include <x86intrin.h>
+        #define VIVISECT_VM_PROFILE_RDTSC
+    #else
+        #include <chrono>
+    #endif
+#endif
+namespace vivisect::modules {
+struct VMProfileSnapshot {
+    static constexpr size_t OPCODE_SLOTS = 36;
+    static constexpr size_t HISTOGRAM_BUCKETS = 16;
+    std::array<uint64_t, OPCODE_SLOTS> executions{};
+    std::array<uint64_t, OPCODE_SLOTS> cycles{};
+    std::array<uint64_t, OPCODE_SLOTS> branches_taken{};
+    std::array<uint64_t, OPCODE_SLOTS> branches_not_taken{};
+    std::array<std::array<uint64_t, HISTOGRAM_BUCKETS>, OPCODE_SLOTS> cycle_histogram{};
+    uint64_t mutation_events = 0;
+    uint64_t total_dispatches() const {
+        uint64_t total = 0;
+        for (uint64_t count : executions) total += count;
+        return total;
+    }
+    uint64_t total_cycles() const {
+        uint64_t total = 0;
+        for (uint64_t count : cycles) total += count;
+        return total;
+    }
+    static const char* opcode_name(size_t opcode) {
+        static constexpr const char* names[OPCODE_SLOTS] = {
+            "ADD", "SUB", "MUL", "DIV", "XOR", "AND", "OR", "NOT", "SHL", "SHR",
+            "LOAD", "STORE", "LOAD_IMM", "JUMP", "JUMP_IF_ZERO", "JUMP_IF_NOT_ZERO",
+            "CALL", "RET", "MANGLE_KEY", "JUNK_OP", "NOP",
+            "HOST_CALL", "CUSTOM_22", "CUSTOM_23", "CUSTOM_24", "CUSTOM_25",
+            "CUSTOM_26", "CUSTOM_27", "CUSTOM_28", "CUSTOM_29", "CUSTOM_30", "CUSTOM_31",
+            "LOAD_IMM_ALU", "ALU_JUMP_IF_ZERO", "ALU_JUMP_IF_NOT_ZERO", "LOAD_ALU_STORE"
+        };
+        return opcode < OPCODE_SLOTS ? names[opcode] : "UNKNOWN";
+    }
+    std::ostream& write_csv(std::ostream& out) const {
+        out << "opcode,executions,cycles,avg_cycles,branches_taken,branches_not_taken";
+        for (size_t b = 0; b < HISTOGRAM_BUCKETS; ++b) out << ",hist_" << b;
+        out << "\n";
+        for (size_t op = 0; op < OPCODE_SLOTS; ++op) {
+            if (executions[op] == 0) continue;
+            out << opcode_name(op) << ',' << executions[op] << ',' << cycles[op] << ','
+                << cycles[op] / executions[op] << ',' << branches_taken[op] << ',' << branches_not_taken[op];
+            for (uint64_t count : cycle_histogram[op]) out << ',' << count;
+            out << "\n";
+        }
+        return out;
+    }
+    std::ostream& write_json(std::ostream& out) const {
+        out << "{\"dispatches\":" << total_dispatches()
+            << ",\"cycles\":" << total_cycles()
+            << ",\"mutation_events\":" << mutation_events
+            << ",\"opcodes\":[";
+        bool first = true;
+        for (size_t op = 0; op < OPCODE_SLOTS; ++op) {
+            if (executions[op] == 0) continue;
+            out << (first ? "" : ",")
+                << "{\"opcode\":\"" << opcode_name(op) << "\""
+                << ",\"executions\":" << executions[op]
+                << ",\"cycles\":" << cycles[op]
+                << ",\"branches_taken\":" << branches_taken[op]
+                << ",\"branches_not_taken\":" << branches_not_taken[op]
+                << ",\"histogram\":[";
+            for (size_t b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+                out << (b ? "," : "") << cycle_histogram[op][b];
+            }
+            out << "]}";
+            first = false;
+        }
+        return out << "]}";
+    }
+};
+#ifdef VIVISECT_VM_PROFILING
+class VMProfiler {
+public:
+    static uint64_t read_cycles() {
+#ifdef VIVISECT_VM_PROFILE_RDTSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+    void record(size_t opcode, uint64_t elapsed) {
+        if (opcode >= VMProfileSnapshot::OPCODE_SLOTS) return;
+        snapshot_.executions[opcode]++;
+        snapshot_.cycles[opcode] += elapsed;
+        size_t bucket = 0;
+        while (elapsed > 1 && bucket + 1 < VMProfileSnapshot::HISTOGRAM_BUCKETS) {
+            elapsed >>= 1;
+            ++bucket;
+        }
+        snapshot_.cycle_histogram[opcode][bucket]++;
+    }
+    void record_branch(size_t opcode, bool taken) {
+        if (opcode >= VMProfileSnapshot::OPCODE_SLOTS) return;
+        (taken ? snapshot_.branches_taken : snapshot_.branches_not_taken)[opcode]++;
+    }
+    void record_mutation() {
+        snapshot_.mutation_events++;
+    }
+    const VMProfileSnapshot& snapshot() const { return snapshot_; }
+    void clear() { snapshot_ = VMProfileSnapshot{}; }
+private:
+    VMProfileSnapshot snapshot_;
+};
+#endif
+}
+#endif
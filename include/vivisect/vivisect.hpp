@@ -44,9 +44,19 @@
 #include "core/config.hpp"
 #include "error/error.hpp"
 #include "modules/string_crypt.hpp"
+#include "modules/blob_crypt.hpp"
 #include "modules/mba.hpp"
 #include "modules/control_flow.hpp"
 #include "modules/vm_engine.hpp"
+#include "modules/vm_assembler.hpp"
+#include "modules/vm_optimizer.hpp"
+#include "modules/vm_jit.hpp"
+#include "modules/vm_encrypted.hpp"
+#include "modules/vm_lanes.hpp"
+#include "modules/vm_executor.hpp"
+#include "modules/vm_container.hpp"
+#include "modules/vm_compiled.hpp"
+#include "modules/vm_cfg.hpp"
 #include "modules/anti_debug.hpp"
 #include "modules/junk_code.hpp"
 #ifdef VIVISECT_PLATFORM_WINDOWS